@@ -0,0 +1,400 @@
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <time.h>
+#include "event_simulation.h"
+#include "latency_stats.h"
+#include "profiled_mutex.h"
+#include "child_process.h"
+#include "schedulers.h"
+#include "workload_trace.h"
+
+/*
+    Benchmark driver. Runs the schedulers over sweeps of the sizes that are otherwise fixed in 'posix_utility.h', all in one executable,
+    and reports dispatch throughput, wall time, CPU time, the latency percentiles, the fairness and the mean breakdown of a dispatch (in nano seconds) of every run as JSON or CSV.
+
+    usage: benchmark [options]
+        -s, --schedulers=LIST     schedulers to run, see below. default: all of them
+        -p, --processes=LIST      number of processes. default: NUMBER_OF_PROCESSES
+        -c, --consumers=LIST      number of consumers. default: NUMBER_OF_CONSUMERS
+        -b, --buffer-sizes=LIST   size of the bounded buffer. default: BUFFER_SIZE
+        -t, --time-slices=LIST    round robin time slice, in milli seconds. default: TIME_SLICE
+        -k, --batch-sizes=LIST    processes the creator queues per acquisition of the buffer lock. default: SUBMIT_BATCH_SIZE
+        -r, --repetitions=N       runs of every combination. default: 1
+        -f, --format=json|csv     default: json
+        -o, --output=FILE         default: standard output
+        -w, --workload=FILE       replay a workload trace in every run instead of random processes (see 'workload_trace.h'). the number of processes is that of the trace
+        -x, --forked              back every process with a real forked child that is stopped and continued with signals (see 'child_process.h'), instead of spinning in the consumer
+        -m, --burst-modes=LIST    how a process passes its burst time: spin, sleep (clock_nanosleep) or timerfd. sleeping leaves the cores free, so there can be more consumers than cores. default: spin
+        -v, --verbose             keep the output of the schedulers themselves and their lock profiles (it goes to standard output)
+    a LIST is a comma separated list of values, every combination of them is run.
+    sizes a scheduler does not use (e.g. the number of consumers of sjf_unbounded) are not swept for it, it only runs with the first value.
+*/
+
+#define MAX_SWEEP_VALUES 64
+
+#define USES_CONSUMERS 1
+#define USES_BUFFER 2
+#define USES_TIME_SLICE 4
+#define USES_SUBMIT_BATCH 8
+#define USES_BURST_MODE 16
+
+struct scheduler_entry
+{
+    const char* name;
+    void (*run)(struct scheduler_result* result);
+    // which of the sizes the scheduler uses
+    int uses;
+};
+
+struct sweep
+{
+    long int values[MAX_SWEEP_VALUES];
+    int count;
+};
+
+// the discrete-event simulation of a policy, with the same sizes as the threaded schedulers.
+static void run_virtual(int policy, struct scheduler_result* result)
+{
+    struct event_simulation_result simulation;
+    simulateDiscreteEvents(policy, NUMBER_OF_PROCESSES, NUMBER_OF_CONSUMERS, BUFFER_SIZE, &simulation);
+    result->oStats = simulation.oStats;
+    result->iDispatches = simulation.iDispatches;
+}
+
+static void run_virtual_sjf(struct scheduler_result* result)
+{
+    run_virtual(POLICY_SJF, result);
+}
+
+static void run_virtual_rr(struct scheduler_result* result)
+{
+    run_virtual(POLICY_ROUND_ROBIN, result);
+}
+
+static void run_virtual_blocking_rr(struct scheduler_result* result)
+{
+    run_virtual(POLICY_BLOCKING_ROUND_ROBIN, result);
+}
+
+static const struct scheduler_entry schedulers[] =
+{
+    {"sjf_unbounded", run_sjf_unbounded, USES_BURST_MODE},
+    {"rr_unbounded", run_rr_unbounded, USES_TIME_SLICE | USES_BURST_MODE},
+    {"sjf_bounded", run_sjf_bounded, USES_BUFFER | USES_SUBMIT_BATCH | USES_BURST_MODE},
+    {"sjf_bounded_multiple_consumers", run_sjf_bounded_multiple_consumers, USES_BUFFER | USES_CONSUMERS | USES_BURST_MODE},
+    {"srtf_multiple_consumers", run_srtf_multiple_consumers, USES_BUFFER | USES_CONSUMERS | USES_BURST_MODE},
+    {"rr_bounded_multiple_consumers", run_rr_bounded_multiple_consumers, USES_BUFFER | USES_CONSUMERS | USES_TIME_SLICE | USES_BURST_MODE},
+    {"rr_blocking_multiple_consumers", run_rr_blocking_multiple_consumers, USES_BUFFER | USES_CONSUMERS | USES_TIME_SLICE | USES_SUBMIT_BATCH | USES_BURST_MODE},
+    {"sjf_batch", run_sjf_batch, USES_BUFFER | USES_BURST_MODE},
+    {"mlfq_multiple_consumers", run_mlfq_multiple_consumers, USES_BUFFER | USES_CONSUMERS | USES_TIME_SLICE | USES_SUBMIT_BATCH | USES_BURST_MODE},
+    {"cfs_multiple_consumers", run_cfs_multiple_consumers, USES_BUFFER | USES_CONSUMERS | USES_SUBMIT_BATCH | USES_BURST_MODE},
+    {"edf_single_consumer", run_edf_single_consumer, USES_BUFFER | USES_TIME_SLICE | USES_BURST_MODE},
+    {"edf_multiple_consumers", run_edf_multiple_consumers, USES_BUFFER | USES_CONSUMERS | USES_TIME_SLICE | USES_BURST_MODE},
+    {"rr_per_cpu", run_rr_per_cpu, USES_BUFFER | USES_CONSUMERS | USES_TIME_SLICE | USES_BURST_MODE},
+    {"virtual_sjf", run_virtual_sjf, USES_BUFFER | USES_CONSUMERS},
+    {"virtual_rr", run_virtual_rr, USES_BUFFER | USES_CONSUMERS | USES_TIME_SLICE},
+    {"virtual_blocking_rr", run_virtual_blocking_rr, USES_BUFFER | USES_CONSUMERS | USES_TIME_SLICE},
+};
+
+#define NUMBER_OF_SCHEDULERS ((int) (sizeof(schedulers) / sizeof(schedulers[0])))
+
+static void usage(const char* program)
+{
+    int i;
+    fprintf(stderr, "usage: %s [-s schedulers] [-p processes] [-c consumers] [-b buffer sizes] [-t time slices] [-k batch sizes] [-r repetitions] [-f json|csv] [-o file] [-w workload] [-x] [-m burst modes] [-v]\n", program);
+    fprintf(stderr, "lists are comma separated, every combination is run. schedulers:");
+    for(i = 0; i < NUMBER_OF_SCHEDULERS; i++)
+        fprintf(stderr, " %s", schedulers[i].name);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+// parses a comma separated list of positive numbers. returns 0 if it is not one.
+static int parse_sweep(const char* text, struct sweep* sweep)
+{
+    sweep->count = 0;
+    while(*text != '\0')
+    {
+        char* end;
+        long int value = strtol(text, &end, 10);
+        if(end == text || value <= 0 || sweep->count == MAX_SWEEP_VALUES || (*end != ',' && *end != '\0'))
+            return 0;
+        sweep->values[sweep->count++] = value;
+        text = *end == ',' ? end + 1 : end;
+    }
+    return sweep->count > 0;
+}
+
+// parses a comma separated list of burst mode names, see 'posix_utility.h'. returns 0 if a name is unknown.
+static int parse_burst_modes(const char* text, struct sweep* sweep)
+{
+    char* names = strdup(text);
+    char* save;
+    char* name;
+    int ok = 1;
+    sweep->count = 0;
+    for(name = strtok_r(names, ",", &save); name != (void*)0; name = strtok_r((void*)0, ",", &save))
+    {
+        int mode = parseBurstMode(name);
+        if(mode < 0 || sweep->count == MAX_SWEEP_VALUES)
+        {
+            fprintf(stderr, "unknown burst mode '%s'\n", name);
+            ok = 0;
+        }
+        else
+            sweep->values[sweep->count++] = mode;
+    }
+    free(names);
+    return ok && sweep->count > 0;
+}
+
+// parses a comma separated list of scheduler names into flags. returns 0 if a name is unknown.
+static int parse_schedulers(const char* text, int* selected)
+{
+    int i;
+    char* names = strdup(text);
+    char* save;
+    char* name;
+    int ok = 1;
+    memset(selected, 0, NUMBER_OF_SCHEDULERS * sizeof(int));
+    for(name = strtok_r(names, ",", &save); name != (void*)0; name = strtok_r((void*)0, ",", &save))
+    {
+        int found = 0;
+        for(i = 0; i < NUMBER_OF_SCHEDULERS; i++)
+        {
+            if(strcmp(name, schedulers[i].name) == 0)
+            {
+                selected[i] = 1;
+                found = 1;
+            }
+        }
+        if(!found)
+        {
+            fprintf(stderr, "unknown scheduler '%s'\n", name);
+            ok = 0;
+        }
+    }
+    free(names);
+    return ok;
+}
+
+static double seconds_of(clockid_t clock)
+{
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void print_csv_header(FILE* output)
+{
+    const char* latencies[] = {"response", "turnaround", "waiting"};
+    int i;
+    fprintf(output, "scheduler,processes,consumers,buffer_size,time_slice,batch_size,forked,burst_mode,repetition,dispatches,wall_ms,cpu_ms,dispatches_per_second");
+    for(i = 0; i < 3; i++)
+        fprintf(output, ",%s_mean_ms,%s_p50_ms,%s_p90_ms,%s_p99_ms,%s_p999_ms,%s_max_ms", latencies[i], latencies[i], latencies[i], latencies[i], latencies[i], latencies[i]);
+    fprintf(output, ",fairness,queue_wait_mean_ns,selection_mean_ns,run_mean_ns,requeue_mean_ns,scheduler_cost\n");
+}
+
+static void print_histogram(FILE* output, int json, const char* name, const struct latency_histogram* histogram)
+{
+    if(json)
+        fprintf(output, ", \"%s\": {\"mean_ms\": %lld, \"p50_ms\": %lld, \"p90_ms\": %lld, \"p99_ms\": %lld, \"p999_ms\": %lld, \"max_ms\": %lld}", name,
+            latency_histogram_mean(histogram), latency_histogram_percentile(histogram, 50.0), latency_histogram_percentile(histogram, 90.0),
+            latency_histogram_percentile(histogram, 99.0), latency_histogram_percentile(histogram, 99.9), histogram->iMax);
+    else
+        fprintf(output, ",%lld,%lld,%lld,%lld,%lld,%lld",
+            latency_histogram_mean(histogram), latency_histogram_percentile(histogram, 50.0), latency_histogram_percentile(histogram, 90.0),
+            latency_histogram_percentile(histogram, 99.0), latency_histogram_percentile(histogram, 99.9), histogram->iMax);
+}
+
+static void print_result(FILE* output, int json, int first, const char* name, int repetition, const struct scheduler_result* result, double wall_time, double cpu_time)
+{
+    double throughput = wall_time > 0 ? result->iDispatches / wall_time : 0;
+    if(json)
+    {
+        fprintf(output, "%s  {\"scheduler\": \"%s\", \"processes\": %d, \"consumers\": %d, \"buffer_size\": %d, \"time_slice\": %d, \"batch_size\": %d, \"forked\": %d, \"burst_mode\": \"%s\", \"repetition\": %d, "
+            "\"dispatches\": %ld, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"dispatches_per_second\": %.1f",
+            first ? "" : ",\n", name, NUMBER_OF_PROCESSES, NUMBER_OF_CONSUMERS, BUFFER_SIZE, TIME_SLICE, SUBMIT_BATCH_SIZE, FORKED_PROCESSES, getBurstModeName(BURST_MODE), repetition,
+            result->iDispatches, wall_time * 1000, cpu_time * 1000, throughput);
+        print_histogram(output, json, "response_time", &result->oStats.oResponseTime);
+        print_histogram(output, json, "turnaround_time", &result->oStats.oTurnaroundTime);
+        print_histogram(output, json, "waiting_time", &result->oStats.oWaitingTime);
+        fprintf(output, ", \"fairness\": %.4f", latency_stats_fairness(&result->oStats));
+        fprintf(output, ", \"dispatch_ns\": {\"queue_wait\": %lld, \"selection\": %lld, \"run\": %lld, \"requeue\": %lld}, \"scheduler_cost\": %.6f}",
+            latency_histogram_mean(&result->oStats.oQueueWait), latency_histogram_mean(&result->oStats.oSelection), latency_histogram_mean(&result->oStats.oRun),
+            latency_histogram_mean(&result->oStats.oRequeue), latency_stats_scheduler_cost(&result->oStats));
+    }
+    else
+    {
+        fprintf(output, "%s,%d,%d,%d,%d,%d,%d,%s,%d,%ld,%.3f,%.3f,%.1f", name, NUMBER_OF_PROCESSES, NUMBER_OF_CONSUMERS, BUFFER_SIZE, TIME_SLICE, SUBMIT_BATCH_SIZE, FORKED_PROCESSES, getBurstModeName(BURST_MODE), repetition,
+            result->iDispatches, wall_time * 1000, cpu_time * 1000, throughput);
+        print_histogram(output, json, "", &result->oStats.oResponseTime);
+        print_histogram(output, json, "", &result->oStats.oTurnaroundTime);
+        print_histogram(output, json, "", &result->oStats.oWaitingTime);
+        fprintf(output, ",%.4f,%lld,%lld,%lld,%lld,%.6f\n", latency_stats_fairness(&result->oStats),
+            latency_histogram_mean(&result->oStats.oQueueWait), latency_histogram_mean(&result->oStats.oSelection), latency_histogram_mean(&result->oStats.oRun),
+            latency_histogram_mean(&result->oStats.oRequeue), latency_stats_scheduler_cost(&result->oStats));
+    }
+    fflush(output);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option options[] =
+    {
+        {"schedulers", required_argument, (void*)0, 's'},
+        {"processes", required_argument, (void*)0, 'p'},
+        {"consumers", required_argument, (void*)0, 'c'},
+        {"buffer-sizes", required_argument, (void*)0, 'b'},
+        {"time-slices", required_argument, (void*)0, 't'},
+        {"batch-sizes", required_argument, (void*)0, 'k'},
+        {"repetitions", required_argument, (void*)0, 'r'},
+        {"format", required_argument, (void*)0, 'f'},
+        {"output", required_argument, (void*)0, 'o'},
+        {"workload", required_argument, (void*)0, 'w'},
+        {"forked", no_argument, (void*)0, 'x'},
+        {"burst-modes", required_argument, (void*)0, 'm'},
+        {"verbose", no_argument, (void*)0, 'v'},
+        {(void*)0, 0, (void*)0, 0}
+    };
+    int selected[NUMBER_OF_SCHEDULERS];
+    struct sweep processes = {{NUMBER_OF_PROCESSES}, 1};
+    struct sweep consumers = {{NUMBER_OF_CONSUMERS}, 1};
+    struct sweep buffer_sizes = {{BUFFER_SIZE}, 1};
+    struct sweep time_slices = {{TIME_SLICE}, 1};
+    struct sweep batch_sizes = {{SUBMIT_BATCH_SIZE}, 1};
+    struct sweep burst_modes = {{BURST_MODE}, 1};
+    struct sweep repetitions = {{1}, 1};
+    const char* output_name = (void*)0;
+    const char* workload_name = (void*)0;
+    int json = 1;
+    int verbose = 0;
+    int option, i;
+    for(i = 0; i < NUMBER_OF_SCHEDULERS; i++)
+        selected[i] = 1;
+    while((option = getopt_long(argc, argv, "s:p:c:b:t:k:r:f:o:w:xm:v", options, (void*)0)) != -1)
+    {
+        int ok = 1;
+        if(option == 's')
+            ok = parse_schedulers(optarg, selected);
+        else if(option == 'p')
+            ok = parse_sweep(optarg, &processes);
+        else if(option == 'c')
+            ok = parse_sweep(optarg, &consumers);
+        else if(option == 'b')
+            ok = parse_sweep(optarg, &buffer_sizes);
+        else if(option == 't')
+            ok = parse_sweep(optarg, &time_slices);
+        else if(option == 'k')
+            ok = parse_sweep(optarg, &batch_sizes);
+        else if(option == 'r')
+            ok = parse_sweep(optarg, &repetitions) && repetitions.count == 1;
+        else if(option == 'f')
+        {
+            json = strcmp(optarg, "json") == 0;
+            ok = json || strcmp(optarg, "csv") == 0;
+        }
+        else if(option == 'o')
+            output_name = optarg;
+        else if(option == 'w')
+            ok = workload_trace_open(optarg) > 0 && (workload_name = optarg) != (void*)0;
+        else if(option == 'x')
+            oSchedulerParameters.iForkedProcesses = 1;
+        else if(option == 'm')
+            ok = parse_burst_modes(optarg, &burst_modes);
+        else if(option == 'v')
+            verbose = 1;
+        else
+            ok = 0;
+        if(!ok)
+            usage(argv[0]);
+    }
+    if(optind != argc)
+        usage(argv[0]);
+    if(workload_name != (void*)0)
+    {
+        // the trace was only opened to check it, every run opens it again. there is nothing to sweep in the number of processes.
+        workload_trace_close();
+        processes.count = 1;
+    }
+
+    // the results get a stream of their own, so that the output of the schedulers can be thrown away without losing them.
+    FILE* output = output_name != (void*)0 ? fopen(output_name, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if(output == (void*)0)
+    {
+        perror(output_name != (void*)0 ? output_name : "stdout");
+        return 1;
+    }
+    if(!verbose)
+    {
+        fflush(stdout);
+        int null_device = open("/dev/null", O_WRONLY);
+        dup2(null_device, STDOUT_FILENO);
+        close(null_device);
+    }
+
+    if(json)
+        fprintf(output, "[\n");
+    else
+        print_csv_header(output);
+    int first = 1;
+    int s, p, c, b, t, k, m, r;
+    for(s = 0; s < NUMBER_OF_SCHEDULERS; s++)
+    {
+        if(!selected[s])
+            continue;
+        const struct scheduler_entry* scheduler = &schedulers[s];
+        int consumer_count = scheduler->uses & USES_CONSUMERS ? consumers.count : 1;
+        int buffer_count = scheduler->uses & USES_BUFFER ? buffer_sizes.count : 1;
+        int time_slice_count = scheduler->uses & USES_TIME_SLICE ? time_slices.count : 1;
+        int batch_count = scheduler->uses & USES_SUBMIT_BATCH ? batch_sizes.count : 1;
+        int burst_mode_count = scheduler->uses & USES_BURST_MODE ? burst_modes.count : 1;
+        for(p = 0; p < processes.count; p++)
+        for(c = 0; c < consumer_count; c++)
+        for(b = 0; b < buffer_count; b++)
+        for(t = 0; t < time_slice_count; t++)
+        for(k = 0; k < batch_count; k++)
+        for(m = 0; m < burst_mode_count; m++)
+        for(r = 0; r < repetitions.values[0]; r++)
+        {
+            oSchedulerParameters.iNumberOfProcesses = processes.values[p];
+            // the replay starts from the first job again. this also sets the number of processes.
+            if(workload_name != (void*)0)
+                workload_trace_open(workload_name);
+            oSchedulerParameters.iNumberOfConsumers = consumers.values[c];
+            oSchedulerParameters.iBufferSize = buffer_sizes.values[b];
+            oSchedulerParameters.iTimeSlice = time_slices.values[t];
+            oSchedulerParameters.iSubmitBatchSize = batch_sizes.values[k];
+            oSchedulerParameters.iBurstMode = burst_modes.values[m];
+            fprintf(stderr, "%s: processes = %d, consumers = %d, buffer size = %d, time slice = %d, batch size = %d, burst mode = %s, repetition %d\n",
+                scheduler->name, NUMBER_OF_PROCESSES, NUMBER_OF_CONSUMERS, BUFFER_SIZE, TIME_SLICE, SUBMIT_BATCH_SIZE, getBurstModeName(BURST_MODE), r);
+            // every run gets the same sequence of processes, so the schedulers are compared on the same workload.
+            setRandomSeed(RANDOM_SEED);
+            resetProcessIds();
+            profiled_mutex_reset_stats();
+            child_process_reset_stats();
+            struct scheduler_result result;
+            double wall_start = seconds_of(CLOCK_MONOTONIC);
+            double cpu_start = seconds_of(CLOCK_PROCESS_CPUTIME_ID);
+            scheduler->run(&result);
+            double cpu_time = seconds_of(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+            double wall_time = seconds_of(CLOCK_MONOTONIC) - wall_start;
+            // the lock profile goes with the output of the scheduler, i.e. it is only kept with --verbose.
+            profiled_mutex_print_stats();
+            child_process_print_stats();
+            fflush(stdout);
+            workload_trace_close();
+            print_result(output, json, first, scheduler->name, r, &result, wall_time, cpu_time);
+            first = 0;
+        }
+    }
+    if(json)
+        fprintf(output, "%s]\n", first ? "" : "\n");
+    fclose(output);
+    return 0;
+}
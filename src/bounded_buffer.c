@@ -0,0 +1,139 @@
+#include "bounded_buffer.h"
+
+void bounded_buffer_init(struct bounded_buffer * oBuffer, size_t iCapacity)
+{
+	profiled_mutex_init(&(oBuffer->oLock), "bounded buffer");
+	pthread_cond_init(&(oBuffer->oNotFull), NULL);
+	pthread_cond_init(&(oBuffer->oNotEmpty), NULL);
+	oBuffer->iCapacity = iCapacity;
+	oBuffer->iLive = 0;
+	oBuffer->iQueued = 0;
+	oBuffer->iClosed = 0;
+}
+
+void bounded_buffer_destroy(struct bounded_buffer * oBuffer)
+{
+	pthread_cond_destroy(&(oBuffer->oNotEmpty));
+	pthread_cond_destroy(&(oBuffer->oNotFull));
+	profiled_mutex_destroy(&(oBuffer->oLock));
+}
+
+/*
+ * Called by the creator before adding a process. Blocks until the buffer has space, and returns with the buffer locked.
+ */
+void bounded_buffer_begin_add(struct bounded_buffer * oBuffer)
+{
+	profiled_mutex_lock(&(oBuffer->oLock));
+	while(oBuffer->iLive >= oBuffer->iCapacity)
+		profiled_mutex_wait(&(oBuffer->oLock), &(oBuffer->oNotFull));
+}
+
+/*
+ * Called by the creator once the process has been put in the ready queue. Wakes up one waiting consumer and unlocks the buffer.
+ */
+void bounded_buffer_end_add(struct bounded_buffer * oBuffer)
+{
+	bounded_buffer_end_add_batch(oBuffer, 1);
+}
+
+/*
+ * Called by the creator before adding up to iWanted processes in one go. Blocks until the buffer has space, and returns with the buffer locked.
+ * Returns how many processes fit, at least 1. The creator only generates that many, while it holds the lock, so a process never waits outside the buffer once it exists.
+ */
+size_t bounded_buffer_begin_add_batch(struct bounded_buffer * oBuffer, size_t iWanted)
+{
+	bounded_buffer_begin_add(oBuffer);
+	size_t iFree = oBuffer->iCapacity - oBuffer->iLive;
+	return iWanted < iFree ? iWanted : iFree;
+}
+
+/*
+ * Called by the creator once iCount processes have been put in the ready queue. Wakes up as many waiting consumers and unlocks the buffer.
+ */
+void bounded_buffer_end_add_batch(struct bounded_buffer * oBuffer, size_t iCount)
+{
+	oBuffer->iLive += iCount;
+	oBuffer->iQueued += iCount;
+	if(iCount == 1)
+		pthread_cond_signal(&(oBuffer->oNotEmpty));
+	else if(iCount > 1)
+		pthread_cond_broadcast(&(oBuffer->oNotEmpty));
+	profiled_mutex_unlock(&(oBuffer->oLock));
+}
+
+/*
+ * Called by a consumer before taking a process out of the ready queue. Blocks until a process is queued, and returns 1 with the buffer locked.
+ * Returns 0, with the buffer unlocked, once the creator has finished and every process it added has finished as well.
+ */
+int bounded_buffer_begin_take(struct bounded_buffer * oBuffer)
+{
+	profiled_mutex_lock(&(oBuffer->oLock));
+	while(oBuffer->iQueued == 0 && !bounded_buffer_finished(oBuffer))
+		profiled_mutex_wait(&(oBuffer->oLock), &(oBuffer->oNotEmpty));
+	if(oBuffer->iQueued == 0)
+	{
+		profiled_mutex_unlock(&(oBuffer->oLock));
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * Called by a consumer once it has taken a process out of the ready queue. The process still counts towards the capacity until it is retired.
+ */
+void bounded_buffer_end_take(struct bounded_buffer * oBuffer)
+{
+	oBuffer->iQueued--;
+	profiled_mutex_unlock(&(oBuffer->oLock));
+}
+
+/*
+ * Called by a consumer before putting processes it took back into the ready queue (e.g. a preempted round robin process). Never blocks on the capacity, as these processes are already live.
+ */
+void bounded_buffer_begin_requeue(struct bounded_buffer * oBuffer)
+{
+	profiled_mutex_lock(&(oBuffer->oLock));
+}
+
+void bounded_buffer_end_requeue(struct bounded_buffer * oBuffer, size_t iCount)
+{
+	oBuffer->iQueued += iCount;
+	if(iCount == 1)
+		pthread_cond_signal(&(oBuffer->oNotEmpty));
+	else if(iCount > 1)
+		pthread_cond_broadcast(&(oBuffer->oNotEmpty));
+	profiled_mutex_unlock(&(oBuffer->oLock));
+}
+
+/*
+ * Called by a consumer once a process it took has finished, freeing up its space in the buffer.
+ */
+void bounded_buffer_retire(struct bounded_buffer * oBuffer)
+{
+	profiled_mutex_lock(&(oBuffer->oLock));
+	oBuffer->iLive--;
+	pthread_cond_signal(&(oBuffer->oNotFull));
+	// the last process is done, let all the waiting consumers find out that there is nothing left
+	if(bounded_buffer_finished(oBuffer))
+		pthread_cond_broadcast(&(oBuffer->oNotEmpty));
+	profiled_mutex_unlock(&(oBuffer->oLock));
+}
+
+/*
+ * Called by the creator once it has added all of its processes.
+ */
+void bounded_buffer_close(struct bounded_buffer * oBuffer)
+{
+	profiled_mutex_lock(&(oBuffer->oLock));
+	oBuffer->iClosed = 1;
+	pthread_cond_broadcast(&(oBuffer->oNotEmpty));
+	profiled_mutex_unlock(&(oBuffer->oLock));
+}
+
+/*
+ * Returns true once the creator has finished and every process it added has finished as well. Must be called with the buffer locked, i.e. between a begin and an end call.
+ */
+int bounded_buffer_finished(const struct bounded_buffer * oBuffer)
+{
+	return oBuffer->iClosed && oBuffer->iLive == 0;
+}
@@ -0,0 +1,43 @@
+#ifndef BOUNDED_BUFFER_H
+#define BOUNDED_BUFFER_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include "profiled_mutex.h"
+
+/*
+ * Bounded buffer monitor shared by the creator and the consumers of the bounded schedulers.
+ * The buffer does not hold the processes itself: the ready queue (a list or a heap) is owned by the scheduler and is only touched between a begin and an end call, i.e. while the buffer lock is held.
+ * The capacity limits the number of live processes, that is processes which have been added and have not finished yet, whether they are queued or running.
+ * Threads that cannot continue sleep on a condition variable instead of polling, so idle creators and consumers do not use any CPU.
+ * The lock is a profiled_mutex, so the time the threads wait for it and hold it is reported per call site.
+ */
+struct bounded_buffer
+{
+	struct profiled_mutex oLock;
+	pthread_cond_t oNotFull;
+	pthread_cond_t oNotEmpty;
+	size_t iCapacity;
+	// processes added to the buffer which have not finished yet (queued or running)
+	size_t iLive;
+	// processes currently waiting in the ready queue
+	size_t iQueued;
+	// set by the creator once it will not add any more processes
+	int iClosed;
+};
+
+void bounded_buffer_init(struct bounded_buffer * oBuffer, size_t iCapacity);
+void bounded_buffer_destroy(struct bounded_buffer * oBuffer);
+void bounded_buffer_begin_add(struct bounded_buffer * oBuffer);
+void bounded_buffer_end_add(struct bounded_buffer * oBuffer);
+size_t bounded_buffer_begin_add_batch(struct bounded_buffer * oBuffer, size_t iWanted);
+void bounded_buffer_end_add_batch(struct bounded_buffer * oBuffer, size_t iCount);
+int bounded_buffer_begin_take(struct bounded_buffer * oBuffer);
+void bounded_buffer_end_take(struct bounded_buffer * oBuffer);
+void bounded_buffer_begin_requeue(struct bounded_buffer * oBuffer);
+void bounded_buffer_end_requeue(struct bounded_buffer * oBuffer, size_t iCount);
+void bounded_buffer_retire(struct bounded_buffer * oBuffer);
+void bounded_buffer_close(struct bounded_buffer * oBuffer);
+int bounded_buffer_finished(const struct bounded_buffer * oBuffer);
+
+#endif
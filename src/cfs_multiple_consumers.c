@@ -0,0 +1,200 @@
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include "bounded_buffer.h"
+#include "process_tree.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
+
+/*
+    CFS, Bounded & MC (Completely Fair Scheduler with Bounding Buffer and Multiple Consumers) Implementation of predefined process.
+    The ready queue is a red-black tree on the virtual runtime of the processes, and a consumer always runs the process that has had the least weighted CPU time so far.
+    The process runs for its share of CFS_TARGET_LATENCY (by nice weight), is charged the time it ran, and goes back into the tree if it has not finished.
+    Predefined constraints are preprocessor macros in 'posix_utility.h'
+*/
+
+/* pthread functionality requires that all functions ran on a separate thread must return void* and take a single void* parameter.
+however, multiple parameters will be requires, such as a pointer to the ready queue, the bounded buffer etc.
+to solve this, the following structs are used to contain all required data:
+*/
+
+// everything the threads share. the tree is only touched while the buffer lock is held.
+struct shared_queues
+{
+    struct bounded_buffer buffer;
+    struct process_tree ready_tree;
+};
+
+struct creator_pack
+{
+    struct shared_queues* queues;
+    // number of times the creator took the buffer lock to queue its processes.
+    long int lock_acquisitions;
+};
+
+struct consumer_pack
+{
+    unsigned int consumer_id;
+    struct shared_queues* queues;
+    // every consumer records into its own statistics block, so consumers never write to the same memory. they are merged once the consumer has been joined.
+    struct latency_stats stats;
+    // number of times this consumer ran a process
+    long int dispatches;
+};
+
+static int is_finished(struct process* a_process)
+{
+    return a_process->iState == FINISHED;
+}
+
+static void* create_processes(void* creator_package)
+{
+    struct creator_pack* creator = (struct creator_pack*) creator_package;
+    // the workload is drawn from a random stream of its own, so it is the same in every run whatever the consumers draw.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    struct shared_queues* queues = creator->queues;
+    // the processes that are being queued. the batch size is only known at run time and may be large, so the batch is not on the stack of the thread.
+    // a batch never holds more processes than fit in the buffer.
+    struct process** batch = (struct process**) calloc(SUBMIT_BATCH_SIZE < BUFFER_SIZE ? SUBMIT_BATCH_SIZE : BUFFER_SIZE, sizeof(struct process*));
+    assert(batch != NULL);
+    size_t processes_created = 0;
+    size_t i;
+    while(processes_created < NUMBER_OF_PROCESSES)
+    {
+        size_t batch_size = NUMBER_OF_PROCESSES - processes_created < (size_t) SUBMIT_BATCH_SIZE ? NUMBER_OF_PROCESSES - processes_created : (size_t) SUBMIT_BATCH_SIZE;
+        // a replayed job that has not arrived yet is waited for before taking the lock, so that waiting never holds up the consumers.
+        waitForNextArrival();
+        // sleeps in bounded_buffer_begin_add_batch while the buffer is full, then only generates as many processes as there is space for, so a process never waits outside the buffer once it exists.
+        // generating a process takes no more than a pool allocation and a few random numbers, so it is done while the lock is held.
+        batch_size = bounded_buffer_begin_add_batch(&queues->buffer, batch_size);
+        size_t added = generateProcesses(batch, batch_size);
+        for(i = 0; i < added; i++)
+        {
+            // starts at the smallest virtual runtime in the tree, so it does not get ahead of the processes that are already there.
+            process_tree_insert(&queues->ready_tree, batch[i]);
+        }
+        bounded_buffer_end_add_batch(&queues->buffer, added);
+        creator->lock_acquisitions++;
+        processes_created += added;
+    }
+    bounded_buffer_close(&queues->buffer);
+    free(batch);
+    pthread_exit(NULL);
+    // Kill the thread. We're done creating processes.
+}
+
+static void* consume_processes(void* consumer_package)
+{
+    struct consumer_pack* consumer = (struct consumer_pack*) consumer_package;
+    struct shared_queues* queues = consumer->queues;
+    // thread does not die until we're no longer creating more and every process has finished.
+    while(bounded_buffer_begin_take(&queues->buffer))
+    {
+        // there is a ready process, from here on until it runs the time goes to selecting it.
+        long long int selecting = getTimeInNanoSeconds();
+        struct process* begin = process_tree_pop_first(&queues->ready_tree);
+        int time_slice = process_tree_time_slice(&queues->ready_tree, begin);
+        bounded_buffer_end_take(&queues->buffer);
+        struct timeval start, end;
+        int previous_burst = begin->iBurstTime;
+        int already_running = begin->iState != NEW;
+        long long int ready_since = begin->iReadySince;
+        long long int running = getTimeInNanoSeconds();
+        simulateRoundRobinProcessWithTimeSlice(begin, time_slice, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        process_tree_charge(begin, (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_usec - start.tv_usec));
+        consumer->dispatches++;
+        unsigned int response_time = getDifferenceInMilliSeconds(begin->oTimeCreated, start);
+        // the writer thread formats and prints the line, the consumer only copies the event into its own ring.
+        trace_log_dispatch(consumer->consumer_id, begin, previous_burst, !already_running, start, end);
+        if(!already_running)
+        {
+            latency_stats_record_response(&consumer->stats, response_time);
+        }
+        if(is_finished(begin))
+        {
+            unsigned int turnaround_time = getDifferenceInMilliSeconds(begin->oTimeCreated, end);
+            latency_stats_record_completion(&consumer->stats, turnaround_time, begin->iInitialBurstTime);
+            process_release(begin);
+            bounded_buffer_retire(&queues->buffer);
+        }
+        else
+        {
+            // used its whole time slice, back into the tree at its new virtual runtime.
+            bounded_buffer_begin_requeue(&queues->buffer);
+            begin->iReadySince = getTimeInNanoSeconds();
+            process_tree_insert(&queues->ready_tree, begin);
+            bounded_buffer_end_requeue(&queues->buffer, 1);
+        }
+        latency_stats_record_dispatch(&consumer->stats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
+    }
+    pthread_exit(NULL);
+    // Kill the thread.
+}
+
+void run_cfs_multiple_consumers(struct scheduler_result* result)
+{
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
+    unsigned int i;
+    struct shared_queues queues;
+    bounded_buffer_init(&queues.buffer, BUFFER_SIZE);
+    process_tree_init(&queues.ready_tree);
+    pthread_t creator_thread_handle;
+    pthread_t* consumer_thread_handle = (pthread_t*) calloc(NUMBER_OF_CONSUMERS, sizeof(pthread_t));
+    struct creator_pack creator;
+    creator.queues = &queues;
+    creator.lock_acquisitions = 0;
+    pthread_create(&creator_thread_handle, NULL, create_processes, &creator);
+    // the packs are on the heap: each of them holds the latency histograms of its consumer, and hundreds of consumers would not fit on the stack.
+    struct consumer_pack* consumer = (struct consumer_pack*) calloc(NUMBER_OF_CONSUMERS, sizeof(struct consumer_pack));
+    assert(consumer != NULL && consumer_thread_handle != NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        consumer[i].consumer_id = i;
+        consumer[i].queues = &queues;
+        latency_stats_init(&consumer[i].stats);
+        consumer[i].dispatches = 0;
+        pthread_create(&consumer_thread_handle[i], NULL, consume_processes, &consumer[i]);
+    }
+
+    pthread_join(creator_thread_handle, NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        pthread_join(consumer_thread_handle[i], NULL);
+        latency_stats_merge(&result->oStats, &consumer[i].stats);
+        result->iDispatches += consumer[i].dispatches;
+    }
+    bounded_buffer_destroy(&queues.buffer);
+    printf("%d processes submitted in %ld lock acquisitions (%.2f per process)\n", NUMBER_OF_PROCESSES, creator.lock_acquisitions, (double) creator.lock_acquisitions / NUMBER_OF_PROCESSES);
+    free(consumer);
+    free(consumer_thread_handle);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    run_cfs_multiple_consumers(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
+    profiled_mutex_print_stats();
+    return 0;
+}
+#endif
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/prctl.h>
+#include "child_process.h"
+
+static atomic_long iChildren = 0;
+static atomic_llong iRequestedTime = 0;
+static atomic_llong iCpuTime = 0;
+// context switches of the reaped children when the statistics were last reset
+static struct rusage oBaseUsage;
+
+/*
+ * The workload of a child: it never blocks and never returns, it is stopped, continued and killed by its parent.
+ */
+static void child_process_spin()
+{
+	volatile unsigned long int iCounter = 0;
+	// the child must not outlive the scheduler, whatever happens to it
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+	for(;;)
+		iCounter++;
+}
+
+/*
+ * CPU time the child has had so far, in nano seconds.
+ */
+static long long int child_process_cpu_time(pid_t iChild)
+{
+	char sPath[64];
+	long long int iRunTime;
+	snprintf(sPath, sizeof(sPath), "/proc/%d/schedstat", (int) iChild);
+	FILE * oFile = fopen(sPath, "r");
+	if(oFile != NULL)
+	{
+		int iRead = fscanf(oFile, "%lld", &iRunTime);
+		fclose(oFile);
+		if(iRead == 1)
+			return iRunTime;
+	}
+	// without scheduler statistics the CPU time is only known in clock ticks
+	unsigned long int iUserTicks, iSystemTicks;
+	snprintf(sPath, sizeof(sPath), "/proc/%d/stat", (int) iChild);
+	oFile = fopen(sPath, "r");
+	assert(oFile != NULL);
+	int iRead = fscanf(oFile, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &iUserTicks, &iSystemTicks);
+	fclose(oFile);
+	assert(iRead == 2);
+	return (long long int) (iUserTicks + iSystemTicks) * (1000000000LL / sysconf(_SC_CLK_TCK));
+}
+
+/*
+ * Runs the child of the process until it has had iBurstTime milli seconds of CPU time, forking it first if the process has never run.
+ * The time stamps are the wall clock times the child was continued and stopped at.
+ */
+void child_process_run(struct process * oTemp, int iBurstTime, struct timeval * oStartTime, struct timeval * oEndTime)
+{
+	gettimeofday(oStartTime, NULL);
+	if(oTemp->iChild == 0)
+	{
+		pid_t iChild = fork();
+		assert(iChild >= 0);
+		if(iChild == 0)
+			child_process_spin();
+		oTemp->iChild = iChild;
+		atomic_fetch_add(&iChildren, 1);
+	}
+	else
+		kill(oTemp->iChild, SIGCONT);
+	long long int iBase = child_process_cpu_time(oTemp->iChild);
+	long long int iTarget = iBase + iBurstTime * 1000000LL;
+	long long int iUsed;
+	// sleep for as long as the child still needs, it may need longer when it has to share the CPU.
+	while((iUsed = child_process_cpu_time(oTemp->iChild)) < iTarget)
+	{
+		long long int iRemaining = iTarget - iUsed;
+		struct timespec oSleep = {iRemaining / 1000000000LL, iRemaining % 1000000000LL};
+		nanosleep(&oSleep, NULL);
+	}
+	kill(oTemp->iChild, SIGSTOP);
+	// the child only counts as stopped once the kernel says so, until then it is still using the CPU.
+	int iStatus;
+	waitpid(oTemp->iChild, &iStatus, WUNTRACED);
+	gettimeofday(oEndTime, NULL);
+	atomic_fetch_add(&iRequestedTime, iBurstTime * 1000000LL);
+	atomic_fetch_add(&iCpuTime, child_process_cpu_time(oTemp->iChild) - iBase);
+}
+
+/*
+ * Kills and reaps the child of a finished process, if it has one.
+ */
+void child_process_end(struct process * oTemp)
+{
+	if(oTemp->iChild == 0)
+		return;
+	kill(oTemp->iChild, SIGKILL);
+	waitpid(oTemp->iChild, NULL, 0);
+	oTemp->iChild = 0;
+}
+
+void child_process_get_stats(struct child_process_stats * oStats)
+{
+	struct rusage oUsage;
+	getrusage(RUSAGE_CHILDREN, &oUsage);
+	oStats->iChildren = atomic_load(&iChildren);
+	oStats->iRequestedTime = atomic_load(&iRequestedTime);
+	oStats->iCpuTime = atomic_load(&iCpuTime);
+	oStats->iVoluntarySwitches = oUsage.ru_nvcsw - oBaseUsage.ru_nvcsw;
+	oStats->iInvoluntarySwitches = oUsage.ru_nivcsw - oBaseUsage.ru_nivcsw;
+}
+
+/*
+ * Prints how much CPU time the children asked for and got, and how often they were switched out. Prints nothing when no process was backed by a child.
+ */
+void child_process_print_stats()
+{
+	struct child_process_stats oStats;
+	child_process_get_stats(&oStats);
+	if(oStats.iChildren == 0)
+		return;
+	printf("Child processes: %ld forked, %.3fms CPU time asked for, %.3fms used (%.2f%% more), %ld voluntary and %ld involuntary context switches\n",
+		oStats.iChildren, oStats.iRequestedTime / 1e6, oStats.iCpuTime / 1e6,
+		oStats.iRequestedTime == 0 ? 0.0 : 100.0 * (oStats.iCpuTime - oStats.iRequestedTime) / oStats.iRequestedTime,
+		oStats.iVoluntarySwitches, oStats.iInvoluntarySwitches);
+}
+
+/*
+ * Starts the statistics from 0 again, e.g. before the next run of a benchmark. Only call it while no scheduler is running.
+ */
+void child_process_reset_stats()
+{
+	atomic_store(&iChildren, 0);
+	atomic_store(&iRequestedTime, 0);
+	atomic_store(&iCpuTime, 0);
+	getrusage(RUSAGE_CHILDREN, &oBaseUsage);
+}
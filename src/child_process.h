@@ -0,0 +1,31 @@
+#ifndef CHILD_PROCESS_H
+#define CHILD_PROCESS_H
+
+#include <sys/time.h>
+#include "posix_utility.h"
+
+/*
+ * Backs a struct process with a real forked child, when FORKED_PROCESSES is set. The child spins on the CPU for as long as it lives.
+ * It is forked the first time the process runs and stopped with SIGSTOP in between, and a run continues it with SIGCONT until it has had the burst time in CPU time,
+ * as read from /proc/<pid>/schedstat (or /proc/<pid>/stat when there are no scheduler statistics). The wall time a run takes is therefore what Linux made of it,
+ * including the other children and threads on the same CPU and the cost of switching between them. The child is killed once the process has finished.
+ * Only the threads that run processes are involved: every child belongs to the consumer that runs it at the time, and no state is shared between the consumers except the statistics.
+ */
+struct child_process_stats
+{
+	long int iChildren;
+	// CPU time the runs asked for, and the CPU time the children got, in nano seconds. they got more because a child is only stopped after its time has been seen to pass
+	long long int iRequestedTime;
+	long long int iCpuTime;
+	// context switches of the children that have been killed, from getrusage
+	long int iVoluntarySwitches;
+	long int iInvoluntarySwitches;
+};
+
+void child_process_run(struct process * oTemp, int iBurstTime, struct timeval * oStartTime, struct timeval * oEndTime);
+void child_process_end(struct process * oTemp);
+void child_process_get_stats(struct child_process_stats * oStats);
+void child_process_print_stats();
+void child_process_reset_stats();
+
+#endif
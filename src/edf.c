@@ -0,0 +1,297 @@
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "process_heap.h"
+#include "bounded_buffer.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
+
+/*
+    EDF (Earliest-Deadline-First) Implementation of predefined periodic tasks, with one consumer or with NUMBER_OF_CONSUMERS consumers.
+    There are NUMBER_OF_PROCESSES periodic tasks. The burst time of a task is drawn like that of any process, and its period is chosen so that the task set
+    asks for EDF_UTILIZATION percent of the consumers. The deadline of a job is the release of the next one (implicit deadlines).
+    A releaser thread releases a new job of every task each period, EDF_RELEASES_PER_TASK times, whether the previous job has finished or not.
+    The ready queue is a heap on the absolute deadline. Consumers run the job with the earliest deadline for at most TIME_SLICE, so a job that is released with an earlier deadline takes over at the next time slice.
+    Besides the latencies (measured from the release of a job), the deadline misses, the lateness of the jobs and the utilization of the consumers are reported.
+    Predefined constraints are preprocessor macros in 'posix_utility.h'
+*/
+
+// everything the threads share. the heap is only touched while the buffer lock is held.
+struct shared_queues
+{
+    struct bounded_buffer buffer;
+    struct process_heap ready_queue;
+};
+
+struct releaser_pack
+{
+    struct shared_queues* queues;
+    int consumers;
+    // utilization the task set asks for, in percent of one consumer
+    double utilization;
+};
+
+// deadline statistics of one consumer, merged once the consumer has been joined
+struct deadline_stats
+{
+    long int jobs;
+    long int misses;
+    // milli seconds that late jobs finished after their deadline
+    struct latency_histogram tardiness;
+    // milli seconds that jobs which made it finished before their deadline
+    struct latency_histogram slack;
+    // micro seconds spent running jobs
+    long long int busy_time;
+};
+
+struct consumer_pack
+{
+    unsigned int consumer_id;
+    struct shared_queues* queues;
+    // every consumer records into its own statistics block, so consumers never write to the same memory. they are merged once the consumer has been joined.
+    struct latency_stats stats;
+    struct deadline_stats deadlines;
+    // number of times this consumer ran a process
+    long int dispatches;
+};
+
+static int is_finished(struct process* a_process)
+{
+    return a_process->iState == FINISHED;
+}
+
+static long long int microseconds_between(struct timeval start, struct timeval end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_usec - start.tv_usec);
+}
+
+// Releases a job of every task each period. The tasks themselves are never queued, every release is a copy of its task which keeps the process id of the task.
+static void* release_jobs(void* releaser_package)
+{
+    struct releaser_pack* releaser = (struct releaser_pack*) releaser_package;
+    // the task set is drawn from a random stream of its own, so it is the same in every run.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    struct shared_queues* queues = releaser->queues;
+    // a workload trace can hold many more tasks than fit on the stack of a thread.
+    struct process** tasks = malloc(NUMBER_OF_PROCESSES * sizeof(struct process*));
+    // the tasks wait for their next release in a heap on the release time, which a task keeps in its oDeadline. the task that is due first is found in O(log n), however many tasks a trace holds.
+    struct process_heap releases;
+    process_heap_init_ordered(&releases, NUMBER_OF_PROCESSES, HEAP_ORDER_DEADLINE);
+    struct process* task;
+    int i;
+    releaser->utilization = 0;
+    for(i = 0; i < NUMBER_OF_PROCESSES; i++)
+    {
+        tasks[i] = generateProcess();
+        // every task gets an equal share of EDF_UTILIZATION percent of the consumers.
+        long int share = (long int) NUMBER_OF_PROCESSES * 100 * tasks[i]->iBurstTime;
+        long int capacity = (long int) EDF_UTILIZATION * releaser->consumers;
+        tasks[i]->iPeriod = (share + capacity - 1) / capacity;
+        tasks[i]->iRelativeDeadline = tasks[i]->iPeriod;
+        releaser->utilization += 100.0 * tasks[i]->iBurstTime / tasks[i]->iPeriod;
+        tasks[i]->oDeadline = tasks[i]->oTimeCreated;
+        process_heap_push(&releases, tasks[i]);
+    }
+    while((task = process_heap_pop(&releases)) != (void*)0)
+    {
+        struct timeval now;
+        getCurrentTime(&now);
+        long long int wait = microseconds_between(now, task->oDeadline);
+        if(wait > 0)
+            usleep(wait);
+        struct process* job = process_alloc();
+        *job = *task;
+        job->oTimeCreated = task->oDeadline;
+        addMilliSeconds(&job->oDeadline, job->iRelativeDeadline);
+        job->iHeapIndex = -1;
+        // the task is released EDF_RELEASES_PER_TASK times, one period apart from its first release.
+        struct timeval end_of_releases = task->oTimeCreated;
+        addMilliSeconds(&end_of_releases, (long int) EDF_RELEASES_PER_TASK * task->iPeriod);
+        addMilliSeconds(&task->oDeadline, task->iPeriod);
+        if(timercmp(&task->oDeadline, &end_of_releases, <))
+            process_heap_push(&releases, task);
+        // sleeps in bounded_buffer_begin_add while the buffer is full. the release time stays the same, so a late release eats into the deadline.
+        bounded_buffer_begin_add(&queues->buffer);
+        // the copy of the task still has the time it was generated at, the job only becomes ready now.
+        job->iReadySince = getTimeInNanoSeconds();
+        process_heap_push(&queues->ready_queue, job);
+        bounded_buffer_end_add(&queues->buffer);
+    }
+    bounded_buffer_close(&queues->buffer);
+    // the tasks never run themselves, they are done once their last job has been released.
+    for(i = 0; i < NUMBER_OF_PROCESSES; i++)
+    {
+        tasks[i]->iState = FINISHED;
+        process_release(tasks[i]);
+    }
+    process_heap_destroy(&releases);
+    free(tasks);
+    pthread_exit(NULL);
+    // Kill the thread. We're done releasing jobs.
+}
+
+static void* consume_processes(void* consumer_package)
+{
+    struct consumer_pack* consumer = (struct consumer_pack*) consumer_package;
+    struct shared_queues* queues = consumer->queues;
+    // thread does not die until every job has been released and has finished.
+    while(bounded_buffer_begin_take(&queues->buffer))
+    {
+        // there is a ready process, from here on until it runs the time goes to selecting it.
+        long long int selecting = getTimeInNanoSeconds();
+        struct process* earliest = process_heap_pop(&queues->ready_queue);
+        bounded_buffer_end_take(&queues->buffer);
+        struct timeval start, end;
+        int previous_burst = earliest->iBurstTime;
+        int already_running = earliest->iState != NEW;
+        long long int ready_since = earliest->iReadySince;
+        long long int running = getTimeInNanoSeconds();
+        simulateRoundRobinProcess(earliest, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        consumer->dispatches++;
+        consumer->deadlines.busy_time += microseconds_between(start, end);
+        unsigned int response_time = getDifferenceInMilliSeconds(earliest->oTimeCreated, start);
+        // the writer thread formats and prints the line, the consumer only copies the event into its own ring.
+        trace_log_dispatch(consumer->consumer_id, earliest, previous_burst, !already_running, start, end);
+        if(!already_running)
+        {
+            latency_stats_record_response(&consumer->stats, response_time);
+        }
+        if(is_finished(earliest))
+        {
+            unsigned int turnaround_time = getDifferenceInMilliSeconds(earliest->oTimeCreated, end);
+            latency_stats_record_completion(&consumer->stats, turnaround_time, earliest->iInitialBurstTime);
+            consumer->deadlines.jobs++;
+            if(timercmp(&end, &earliest->oDeadline, >))
+            {
+                consumer->deadlines.misses++;
+                latency_histogram_record(&consumer->deadlines.tardiness, getDifferenceInMilliSeconds(earliest->oDeadline, end));
+            }
+            else
+                latency_histogram_record(&consumer->deadlines.slack, getDifferenceInMilliSeconds(end, earliest->oDeadline));
+            process_release(earliest);
+            bounded_buffer_retire(&queues->buffer);
+        }
+        else
+        {
+            // used its whole time slice, back into the heap. a job with an earlier deadline goes first now.
+            bounded_buffer_begin_requeue(&queues->buffer);
+            earliest->iReadySince = getTimeInNanoSeconds();
+            process_heap_push(&queues->ready_queue, earliest);
+            bounded_buffer_end_requeue(&queues->buffer, 1);
+        }
+        latency_stats_record_dispatch(&consumer->stats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
+    }
+    pthread_exit(NULL);
+    // Kill the thread.
+}
+
+static void print_lateness(const char* name, const struct latency_histogram* histogram)
+{
+    printf("%-16s p50 = %lldms, p90 = %lldms, p99 = %lldms, max = %lldms (%lld jobs)\n", name,
+        latency_histogram_percentile(histogram, 50.0), latency_histogram_percentile(histogram, 90.0),
+        latency_histogram_percentile(histogram, 99.0), histogram->iMax, histogram->iCount);
+}
+
+static void run_edf(struct scheduler_result* result, int consumers)
+{
+    // response, turnaround and waiting times of every job, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
+    int i;
+    struct shared_queues queues;
+    bounded_buffer_init(&queues.buffer, BUFFER_SIZE);
+    process_heap_init_ordered(&queues.ready_queue, BUFFER_SIZE, HEAP_ORDER_DEADLINE);
+    struct deadline_stats deadlines = {0};
+    latency_histogram_init(&deadlines.tardiness);
+    latency_histogram_init(&deadlines.slack);
+    struct timeval run_start, run_end;
+    gettimeofday(&run_start, NULL);
+    pthread_t releaser_thread_handle;
+    pthread_t* consumer_thread_handle = (pthread_t*) calloc(consumers, sizeof(pthread_t));
+    struct releaser_pack releaser;
+    releaser.queues = &queues;
+    releaser.consumers = consumers;
+    pthread_create(&releaser_thread_handle, NULL, release_jobs, &releaser);
+    // the packs are on the heap: each of them holds the latency histograms of its consumer, and hundreds of consumers would not fit on the stack.
+    struct consumer_pack* consumer = (struct consumer_pack*) calloc(consumers, sizeof(struct consumer_pack));
+    assert(consumer != NULL && consumer_thread_handle != NULL);
+    for(i = 0; i < consumers; i++)
+    {
+        consumer[i].consumer_id = i;
+        consumer[i].queues = &queues;
+        latency_stats_init(&consumer[i].stats);
+        consumer[i].deadlines = deadlines;
+        consumer[i].dispatches = 0;
+        pthread_create(&consumer_thread_handle[i], NULL, consume_processes, &consumer[i]);
+    }
+
+    pthread_join(releaser_thread_handle, NULL);
+    for(i = 0; i < consumers; i++)
+    {
+        pthread_join(consumer_thread_handle[i], NULL);
+        latency_stats_merge(&result->oStats, &consumer[i].stats);
+        result->iDispatches += consumer[i].dispatches;
+        deadlines.jobs += consumer[i].deadlines.jobs;
+        deadlines.misses += consumer[i].deadlines.misses;
+        latency_histogram_merge(&deadlines.tardiness, &consumer[i].deadlines.tardiness);
+        latency_histogram_merge(&deadlines.slack, &consumer[i].deadlines.slack);
+        deadlines.busy_time += consumer[i].deadlines.busy_time;
+    }
+    gettimeofday(&run_end, NULL);
+    process_heap_destroy(&queues.ready_queue);
+    bounded_buffer_destroy(&queues.buffer);
+    long long int capacity = microseconds_between(run_start, run_end) * consumers;
+    printf("EDF with %d consumer(s): %ld jobs, %ld deadline misses (%.1f%%), task set utilization = %.1f%%, measured utilization = %.1f%%\n",
+        consumers, deadlines.jobs, deadlines.misses, deadlines.jobs > 0 ? 100.0 * deadlines.misses / deadlines.jobs : 0.0,
+        releaser.utilization / consumers, capacity > 0 ? 100.0 * deadlines.busy_time / capacity : 0.0);
+    print_lateness("Tardiness:", &deadlines.tardiness);
+    print_lateness("Slack:", &deadlines.slack);
+    free(consumer);
+    free(consumer_thread_handle);
+}
+
+void run_edf_single_consumer(struct scheduler_result* result)
+{
+    run_edf(result, 1);
+}
+
+void run_edf_multiple_consumers(struct scheduler_result* result)
+{
+    run_edf(result, NUMBER_OF_CONSUMERS);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    int consumers;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    for(consumers = 0; consumers < 2; consumers++)
+    {
+        // an optional workload trace gives the tasks instead of random processes, see 'workload_trace.h'. it is replayed once for every run.
+        if(argc > 1 && workload_trace_open(argv[1]) < 0)
+            return 1;
+        if(consumers == 0)
+            run_edf_single_consumer(&result);
+        else
+            run_edf_multiple_consumers(&result);
+        workload_trace_close();
+        printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+        latency_stats_print(&result.oStats, "ms");
+    }
+    trace_log_close();
+    process_pool_print_stats();
+    child_process_print_stats();
+    profiled_mutex_print_stats();
+    return 0;
+}
+#endif
@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "event_simulation.h"
+#include "process_heap.h"
+#include "process_pool.h"
+
+/*
+ * Discrete-event simulation of the schedulers. Instead of threads spinning for the burst time, a single thread keeps a queue of future events ordered on virtual time,
+ * jumps the virtual clock to the next event and handles it. The processes are run through the same simulate*Process functions as the threaded schedulers, with runProcess in VIRTUAL_TIME mode.
+ *
+ * The creator is modelled as in the bounded schedulers: a new process arrives as soon as fewer than iBufferSize processes are live. A buffer size of 0 means unbounded, i.e. all processes arrive at time 0.
+ * Blocked processes wait in the queue of their event type, each event type occurs at a random interval of up to MAX_EVENT_INTERVAL ms and then unblocks its whole queue.
+ */
+
+#define CPU_FREE 0
+#define EVENT_OCCURRED 1
+
+struct simulation_event
+{
+	long int iTime;
+	// breaks ties between events at the same time, so the simulation is deterministic
+	long int iSequence;
+	int iType;
+	// CPU that finished running oProcess, or the event type that occurred
+	int iTarget;
+	struct process * oProcess;
+};
+
+struct event_queue
+{
+	struct simulation_event * aEvents;
+	size_t iSize;
+	size_t iCapacity;
+	long int iNextSequence;
+};
+
+static int event_before(const struct simulation_event * a, const struct simulation_event * b)
+{
+	if(a->iTime != b->iTime)
+		return a->iTime < b->iTime;
+	return a->iSequence < b->iSequence;
+}
+
+static void event_queue_push(struct event_queue * oQueue, long int iTime, int iType, int iTarget, struct process * oProcess)
+{
+	if(oQueue->iSize == oQueue->iCapacity)
+	{
+		oQueue->iCapacity = oQueue->iCapacity == 0 ? 64 : oQueue->iCapacity * 2;
+		oQueue->aEvents = (struct simulation_event *) realloc(oQueue->aEvents, oQueue->iCapacity * sizeof(struct simulation_event));
+		assert(oQueue->aEvents != NULL);
+	}
+	struct simulation_event oEvent;
+	oEvent.iTime = iTime;
+	oEvent.iSequence = oQueue->iNextSequence++;
+	oEvent.iType = iType;
+	oEvent.iTarget = iTarget;
+	oEvent.oProcess = oProcess;
+	size_t iIndex = oQueue->iSize++;
+	while(iIndex > 0 && event_before(&oEvent, &(oQueue->aEvents[(iIndex - 1) / 2])))
+	{
+		oQueue->aEvents[iIndex] = oQueue->aEvents[(iIndex - 1) / 2];
+		iIndex = (iIndex - 1) / 2;
+	}
+	oQueue->aEvents[iIndex] = oEvent;
+}
+
+static int event_queue_pop(struct event_queue * oQueue, struct simulation_event * oEvent)
+{
+	if(oQueue->iSize == 0)
+		return 0;
+	*oEvent = oQueue->aEvents[0];
+	struct simulation_event oLast = oQueue->aEvents[--oQueue->iSize];
+	size_t iIndex = 0;
+	for(;;)
+	{
+		size_t iChild = 2 * iIndex + 1;
+		if(iChild >= oQueue->iSize)
+			break;
+		if(iChild + 1 < oQueue->iSize && event_before(&(oQueue->aEvents[iChild + 1]), &(oQueue->aEvents[iChild])))
+			iChild++;
+		if(!event_before(&(oQueue->aEvents[iChild]), &oLast))
+			break;
+		oQueue->aEvents[iIndex] = oQueue->aEvents[iChild];
+		iIndex = iChild;
+	}
+	if(oQueue->iSize > 0)
+		oQueue->aEvents[iIndex] = oLast;
+	return 1;
+}
+
+static long int to_milli_seconds(struct timeval oTime)
+{
+	return oTime.tv_sec * 1000 + oTime.tv_usec / 1000;
+}
+
+/*
+ * Runs iNumberOfProcesses processes to completion on iNumberOfCpus simulated CPUs under the given policy, entirely in virtual time, and fills in oResult.
+ * Must be called on a thread that is not otherwise using VIRTUAL_TIME mode. The calling thread is back in REAL_TIME mode when the function returns.
+ */
+void simulateDiscreteEvents(int iPolicy, long int iNumberOfProcesses, int iNumberOfCpus, long int iBufferSize, struct event_simulation_result * oResult)
+{
+	struct event_queue oEvents = {NULL, 0, 0, 0};
+	struct process_heap oShortestFirst;
+	struct run_queue oReadyQueue;
+	struct run_queue aEventQueues[NUMBER_OF_EVENT_TYPES];
+	int aEventPending[NUMBER_OF_EVENT_TYPES];
+	int * aIdleCpus = (int *) malloc(iNumberOfCpus * sizeof(int));
+	int iIdleCpus = 0;
+	long int iCreated = 0;
+	long int iLive = 0;
+	long int iQueued = 0;
+	long int iNow = 0;
+	int i;
+
+	assert(aIdleCpus != NULL);
+	memset(oResult, 0, sizeof(struct event_simulation_result));
+	latency_stats_init(&(oResult->oStats));
+	run_queue_init(&oReadyQueue);
+	for(i = 0; i < NUMBER_OF_EVENT_TYPES; i++)
+		run_queue_init(&(aEventQueues[i]));
+	memset(aEventPending, 0, sizeof(aEventPending));
+	process_heap_init(&oShortestFirst, iBufferSize > 0 ? iBufferSize : 1024);
+	for(i = iNumberOfCpus - 1; i >= 0; i--)
+		aIdleCpus[iIdleCpus++] = i;
+	if(iBufferSize <= 0)
+		iBufferSize = iNumberOfProcesses;
+	setSimulationMode(VIRTUAL_TIME);
+
+	for(;;)
+	{
+		struct timeval oNow = {iNow / 1000, (iNow % 1000) * 1000};
+		setVirtualTime(oNow);
+		// the creator adds processes as long as the buffer has space
+		while(iLive < iBufferSize && iCreated < iNumberOfProcesses)
+		{
+			struct process * oTemp = generateProcess();
+			if(iPolicy == POLICY_SJF)
+				process_heap_push(&oShortestFirst, oTemp);
+			else
+				run_queue_push_back(&oReadyQueue, oTemp);
+			iCreated++;
+			iLive++;
+			iQueued++;
+		}
+		// every idle CPU takes the next process and runs it, which schedules the CPU_FREE event for the end of its burst
+		while(iIdleCpus > 0 && iQueued > 0)
+		{
+			struct process * oTemp = iPolicy == POLICY_SJF ? process_heap_pop(&oShortestFirst) : run_queue_pop_front(&oReadyQueue);
+			struct timeval oStartTime, oEndTime;
+			int iFirstRun = oTemp->iState == NEW;
+			iQueued--;
+			setVirtualTime(oNow);
+			if(iPolicy == POLICY_SJF)
+				simulateSJFProcess(oTemp, &oStartTime, &oEndTime);
+			else if(iPolicy == POLICY_ROUND_ROBIN)
+				simulateRoundRobinProcess(oTemp, &oStartTime, &oEndTime);
+			else
+				simulateBlockingRoundRobinProcess(oTemp, &oStartTime, &oEndTime);
+			if(iFirstRun)
+				latency_stats_record_response(&(oResult->oStats), getDifferenceInMilliSeconds(oTemp->oTimeCreated, oStartTime));
+			oResult->iDispatches++;
+			event_queue_push(&oEvents, to_milli_seconds(oEndTime), CPU_FREE, aIdleCpus[--iIdleCpus], oTemp);
+		}
+
+		struct simulation_event oEvent;
+		if(!event_queue_pop(&oEvents, &oEvent))
+			break;
+		iNow = oEvent.iTime;
+		if(oEvent.iType == EVENT_OCCURRED)
+		{
+			// the event happened, everything waiting for it is ready again
+			struct process * oTemp;
+			while((oTemp = run_queue_pop_front(&(aEventQueues[oEvent.iTarget]))) != NULL)
+			{
+				oTemp->iState = READY;
+				run_queue_push_back(&oReadyQueue, oTemp);
+				iQueued++;
+			}
+			aEventPending[oEvent.iTarget] = 0;
+			continue;
+		}
+		struct process * oTemp = oEvent.oProcess;
+		aIdleCpus[iIdleCpus++] = oEvent.iTarget;
+		if(oTemp->iState == FINISHED)
+		{
+			long int iTurnaround = iNow - to_milli_seconds(oTemp->oTimeCreated);
+			latency_stats_record_completion(&(oResult->oStats), iTurnaround, oTemp->iInitialBurstTime);
+			oResult->iProcesses++;
+			oResult->iMakespan = iNow;
+			iLive--;
+			process_release(oTemp);
+		}
+		else if(oTemp->iState == BLOCKED)
+		{
+			run_queue_push_back(&(aEventQueues[oTemp->iEventType]), oTemp);
+			if(!aEventPending[oTemp->iEventType])
+			{
+				aEventPending[oTemp->iEventType] = 1;
+				event_queue_push(&oEvents, iNow + 1 + generateRandomNumber(MAX_EVENT_INTERVAL), EVENT_OCCURRED, oTemp->iEventType, NULL);
+			}
+		}
+		else
+		{
+			// used its whole time slice, back to the end of the ready queue
+			run_queue_push_back(&oReadyQueue, oTemp);
+			iQueued++;
+		}
+	}
+
+	setSimulationMode(REAL_TIME);
+	process_heap_destroy(&oShortestFirst);
+	free(oEvents.aEvents);
+	free(aIdleCpus);
+}
@@ -0,0 +1,26 @@
+#ifndef EVENT_SIMULATION_H
+#define EVENT_SIMULATION_H
+
+#include "posix_utility.h"
+#include "latency_stats.h"
+
+#define POLICY_SJF 0
+#define POLICY_ROUND_ROBIN 1
+#define POLICY_BLOCKING_ROUND_ROBIN 2
+
+/*
+ * Results of a discrete-event simulation. All times are virtual, in milli seconds.
+ */
+struct event_simulation_result
+{
+	long int iProcesses;
+	long int iDispatches;
+	// response, turnaround and waiting times of the processes
+	struct latency_stats oStats;
+	// virtual time at which the last process finished
+	long int iMakespan;
+};
+
+void simulateDiscreteEvents(int iPolicy, long int iNumberOfProcesses, int iNumberOfCpus, long int iBufferSize, struct event_simulation_result * oResult);
+
+#endif
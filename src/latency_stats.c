@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <string.h>
+#include "latency_stats.h"
+#include "posix_utility.h"
+
+/*
+ * Values below LATENCY_SUB_BUCKETS get a bucket each. Above that, a value with its highest bit at position n falls in the range [2^n, 2^(n+1)[,
+ * which is split in LATENCY_SUB_BUCKETS / 2 buckets of equal width (the lower half of the sub buckets is already covered by the previous range).
+ */
+static int latency_bucket(long long int iValue)
+{
+	if(iValue < 0)
+		iValue = 0;
+	if(iValue >= (1LL << LATENCY_MAX_VALUE_BITS))
+		iValue = (1LL << LATENCY_MAX_VALUE_BITS) - 1;
+	if(iValue < LATENCY_SUB_BUCKETS)
+		return (int) iValue;
+	int iHighestBit = 63 - __builtin_clzll((unsigned long long) iValue);
+	int iShift = iHighestBit - LATENCY_SUB_BUCKET_BITS + 1;
+	return iShift * (LATENCY_SUB_BUCKETS / 2) + (int) (iValue >> iShift);
+}
+
+/*
+ * Returns the largest value that falls in the given bucket.
+ */
+static long long int latency_bucket_upper_bound(int iBucket)
+{
+	if(iBucket < LATENCY_SUB_BUCKETS)
+		return iBucket;
+	int iShift = iBucket / (LATENCY_SUB_BUCKETS / 2) - 1;
+	long long int iSubBucket = iBucket - (long long int) iShift * (LATENCY_SUB_BUCKETS / 2);
+	return ((iSubBucket + 1) << iShift) - 1;
+}
+
+void latency_histogram_init(struct latency_histogram * oHistogram)
+{
+	memset(oHistogram, 0, sizeof(struct latency_histogram));
+}
+
+void latency_histogram_record(struct latency_histogram * oHistogram, long long int iValue)
+{
+	oHistogram->aCounts[latency_bucket(iValue)]++;
+	oHistogram->iCount++;
+	oHistogram->iSum += iValue;
+	if(iValue > oHistogram->iMax)
+		oHistogram->iMax = iValue;
+}
+
+void latency_histogram_merge(struct latency_histogram * oDestination, const struct latency_histogram * oSource)
+{
+	int i;
+	for(i = 0; i < LATENCY_BUCKETS; i++)
+		oDestination->aCounts[i] += oSource->aCounts[i];
+	oDestination->iCount += oSource->iCount;
+	oDestination->iSum += oSource->iSum;
+	if(oSource->iMax > oDestination->iMax)
+		oDestination->iMax = oSource->iMax;
+}
+
+/*
+ * Returns the value below which dPercentile percent of the recorded values fall, rounded up to the end of its bucket (but never above the maximum).
+ */
+long long int latency_histogram_percentile(const struct latency_histogram * oHistogram, double dPercentile)
+{
+	int i;
+	if(oHistogram->iCount == 0)
+		return 0;
+	long long int iRank = (long long int) (dPercentile / 100.0 * oHistogram->iCount + 0.5);
+	if(iRank < 1)
+		iRank = 1;
+	long long int iSeen = 0;
+	for(i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		iSeen += oHistogram->aCounts[i];
+		if(iSeen >= iRank)
+		{
+			long long int iValue = latency_bucket_upper_bound(i);
+			return iValue < oHistogram->iMax ? iValue : oHistogram->iMax;
+		}
+	}
+	return oHistogram->iMax;
+}
+
+long long int latency_histogram_mean(const struct latency_histogram * oHistogram)
+{
+	return oHistogram->iCount == 0 ? 0 : oHistogram->iSum / oHistogram->iCount;
+}
+
+void latency_stats_init(struct latency_stats * oStats)
+{
+	latency_histogram_init(&(oStats->oResponseTime));
+	latency_histogram_init(&(oStats->oTurnaroundTime));
+	latency_histogram_init(&(oStats->oWaitingTime));
+	oStats->dSlowdownSum = 0;
+	oStats->dSlowdownSquareSum = 0;
+	latency_histogram_init(&(oStats->oQueueWait));
+	latency_histogram_init(&(oStats->oSelection));
+	latency_histogram_init(&(oStats->oRun));
+	latency_histogram_init(&(oStats->oRequeue));
+}
+
+void latency_stats_record_response(struct latency_stats * oStats, long long int iResponseTime)
+{
+	latency_histogram_record(&(oStats->oResponseTime), iResponseTime);
+}
+
+/*
+ * Records a finished process. The waiting time is whatever part of the turnaround time was not spent running.
+ */
+void latency_stats_record_completion(struct latency_stats * oStats, long long int iTurnaroundTime, long long int iRunTime)
+{
+	long long int iWaitingTime = iTurnaroundTime - iRunTime;
+	latency_histogram_record(&(oStats->oTurnaroundTime), iTurnaroundTime);
+	latency_histogram_record(&(oStats->oWaitingTime), iWaitingTime > 0 ? iWaitingTime : 0);
+	double dSlowdown = iRunTime > 0 && iTurnaroundTime > iRunTime ? (double) iTurnaroundTime / iRunTime : 1.0;
+	oStats->dSlowdownSum += dSlowdown;
+	oStats->dSlowdownSquareSum += dSlowdown * dSlowdown;
+}
+
+/*
+ * Records the breakdown of one dispatch from its time stamps, in nano seconds on the getTimeInNanoSeconds clock: the process was ready since iReady, the consumer started to select a process at iSelecting,
+ * the process ran from iRunning until iStopped, and at iDone it was back in a queue or retired. For a process that blocked, the queue wait includes the time it was blocked.
+ */
+void latency_stats_record_dispatch(struct latency_stats * oStats, long long int iReady, long long int iSelecting, long long int iRunning, long long int iStopped, long long int iDone)
+{
+	// a consumer that was already looking when the process became ready has not waited for it
+	latency_histogram_record(&(oStats->oQueueWait), iSelecting > iReady ? iSelecting - iReady : 0);
+	latency_histogram_record(&(oStats->oSelection), iRunning - iSelecting);
+	latency_histogram_record(&(oStats->oRun), iStopped - iRunning);
+	latency_histogram_record(&(oStats->oRequeue), iDone - iStopped);
+}
+
+/*
+ * Share of the time the consumers spent on dispatches that went to the scheduler itself (selection and requeue) rather than to running processes. 0 if no dispatch was recorded.
+ */
+double latency_stats_scheduler_cost(const struct latency_stats * oStats)
+{
+	long long int iOverhead = oStats->oSelection.iSum + oStats->oRequeue.iSum;
+	long long int iTotal = iOverhead + oStats->oRun.iSum;
+	return iTotal == 0 ? 0.0 : (double) iOverhead / iTotal;
+}
+
+/*
+ * Jain's fairness index of the slowdowns of the finished processes, 1 if none have finished.
+ */
+double latency_stats_fairness(const struct latency_stats * oStats)
+{
+	long long int iCount = oStats->oTurnaroundTime.iCount;
+	if(iCount == 0 || oStats->dSlowdownSquareSum == 0)
+		return 1.0;
+	return oStats->dSlowdownSum * oStats->dSlowdownSum / (iCount * oStats->dSlowdownSquareSum);
+}
+
+void latency_stats_merge(struct latency_stats * oDestination, const struct latency_stats * oSource)
+{
+	latency_histogram_merge(&(oDestination->oResponseTime), &(oSource->oResponseTime));
+	latency_histogram_merge(&(oDestination->oTurnaroundTime), &(oSource->oTurnaroundTime));
+	latency_histogram_merge(&(oDestination->oWaitingTime), &(oSource->oWaitingTime));
+	oDestination->dSlowdownSum += oSource->dSlowdownSum;
+	oDestination->dSlowdownSquareSum += oSource->dSlowdownSquareSum;
+	latency_histogram_merge(&(oDestination->oQueueWait), &(oSource->oQueueWait));
+	latency_histogram_merge(&(oDestination->oSelection), &(oSource->oSelection));
+	latency_histogram_merge(&(oDestination->oRun), &(oSource->oRun));
+	latency_histogram_merge(&(oDestination->oRequeue), &(oSource->oRequeue));
+}
+
+static void latency_histogram_print(const char * sName, const struct latency_histogram * oHistogram, const char * sUnit)
+{
+	printf("%-16s mean = %lld%s, p50 = %lld%s, p90 = %lld%s, p99 = %lld%s, p99.9 = %lld%s, max = %lld%s (%lld samples)\n", sName,
+		latency_histogram_mean(oHistogram), sUnit,
+		latency_histogram_percentile(oHistogram, 50.0), sUnit,
+		latency_histogram_percentile(oHistogram, 90.0), sUnit,
+		latency_histogram_percentile(oHistogram, 99.0), sUnit,
+		latency_histogram_percentile(oHistogram, 99.9), sUnit,
+		oHistogram->iMax, sUnit, oHistogram->iCount);
+}
+
+/*
+ * Prints the mean and the tail percentiles of the three latencies, one line each, and the fairness. When dispatches were recorded, their breakdown and the cost of the scheduler follow.
+ */
+void latency_stats_print(const struct latency_stats * oStats, const char * sUnit)
+{
+	latency_histogram_print("Response Time:", &(oStats->oResponseTime), sUnit);
+	latency_histogram_print("Turnaround Time:", &(oStats->oTurnaroundTime), sUnit);
+	latency_histogram_print("Waiting Time:", &(oStats->oWaitingTime), sUnit);
+	printf("%-16s %.3f (Jain's index of the slowdowns)\n", "Fairness:", latency_stats_fairness(oStats));
+	if(oStats->oRun.iCount == 0)
+		return;
+	latency_histogram_print("Queue Wait:", &(oStats->oQueueWait), "ns");
+	latency_histogram_print("Selection:", &(oStats->oSelection), "ns");
+	latency_histogram_print("Run:", &(oStats->oRun), "ns");
+	latency_histogram_print("Requeue:", &(oStats->oRequeue), "ns");
+	printf("%-16s %.3f%% of the dispatch time (selection and requeue, %s clock)\n", "Scheduler Cost:", 100.0 * latency_stats_scheduler_cost(oStats), getClockSource());
+}
@@ -0,0 +1,57 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+// values below 2^LATENCY_SUB_BUCKET_BITS are exact, every power of two range above that is split into 2^(LATENCY_SUB_BUCKET_BITS - 1) linear buckets, which bounds the relative error of a percentile to about 3%
+#define LATENCY_SUB_BUCKET_BITS 6
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+// values up to 2^LATENCY_MAX_VALUE_BITS can be recorded, larger ones are clamped
+#define LATENCY_MAX_VALUE_BITS 40
+#define LATENCY_BUCKETS ((LATENCY_MAX_VALUE_BITS - LATENCY_SUB_BUCKET_BITS + 2) * (LATENCY_SUB_BUCKETS / 2))
+
+/*
+ * Log-bucketed (HDR style) histogram of non-negative latencies. Recording is O(1) and never allocates.
+ * A histogram is not synchronised: every thread records into its own, and the histograms are merged once the threads have been joined.
+ */
+struct latency_histogram
+{
+	long long int aCounts[LATENCY_BUCKETS];
+	long long int iCount;
+	long long int iSum;
+	long long int iMax;
+};
+
+/*
+ * Statistics block of one thread. Response time is measured until the first time a process runs, turnaround time until it finishes,
+ * and waiting time is the part of the turnaround time the process spent not running.
+ * The fairness of a run is Jain's index of the slowdowns (turnaround time / run time) of the processes: 1 when every process was slowed down equally, down to 1/n when one process took all the delay.
+ * Every dispatch is also broken down, in nano seconds, into the time the process waited in a ready queue, the time the consumer took to select it, the time it ran, and the time it took to requeue or retire it.
+ * Selection and requeue are the cost of the scheduler itself, the run time is the simulated work.
+ */
+struct latency_stats
+{
+	struct latency_histogram oResponseTime;
+	struct latency_histogram oTurnaroundTime;
+	struct latency_histogram oWaitingTime;
+	double dSlowdownSum;
+	double dSlowdownSquareSum;
+	struct latency_histogram oQueueWait;
+	struct latency_histogram oSelection;
+	struct latency_histogram oRun;
+	struct latency_histogram oRequeue;
+};
+
+void latency_histogram_init(struct latency_histogram * oHistogram);
+void latency_histogram_record(struct latency_histogram * oHistogram, long long int iValue);
+void latency_histogram_merge(struct latency_histogram * oDestination, const struct latency_histogram * oSource);
+long long int latency_histogram_percentile(const struct latency_histogram * oHistogram, double dPercentile);
+long long int latency_histogram_mean(const struct latency_histogram * oHistogram);
+void latency_stats_init(struct latency_stats * oStats);
+void latency_stats_record_response(struct latency_stats * oStats, long long int iResponseTime);
+void latency_stats_record_completion(struct latency_stats * oStats, long long int iTurnaroundTime, long long int iRunTime);
+void latency_stats_record_dispatch(struct latency_stats * oStats, long long int iReady, long long int iSelecting, long long int iRunning, long long int iStopped, long long int iDone);
+double latency_stats_fairness(const struct latency_stats * oStats);
+double latency_stats_scheduler_cost(const struct latency_stats * oStats);
+void latency_stats_merge(struct latency_stats * oDestination, const struct latency_stats * oSource);
+void latency_stats_print(const struct latency_stats * oStats, const char * sUnit);
+
+#endif
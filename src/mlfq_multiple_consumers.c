@@ -0,0 +1,336 @@
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <assert.h>
+#include <pthread.h>
+#include "bounded_buffer.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
+
+/*
+    MLFQ, Bounded & MC (Multilevel Feedback Queue with Blocking Processes, Bounding Buffer and Multiple Consumers) Implementation of predefined process.
+    There are MLFQ_NUMBER_OF_LEVELS round robin ready queues. New processes start at level 0, and a consumer always runs a process of the highest level that has one.
+    A process that uses its whole time slice moves one level down, where the time slice is longer (see MLFQ_TIME_SLICE_FACTORS), and a process that blocks moves one level up.
+    Short interactive jobs therefore stay at the top and keep a short response time, while long batch jobs sink to the bottom and run in longer turns.
+    So that the long jobs do not starve, every MLFQ_BOOST_INTERVAL milli seconds all processes are moved back to level 0.
+    Blocking works as in 'rr_blocking_multiple_consumers.c'.
+    Predefined constraints are preprocessor macros in 'posix_utility.h'
+*/
+
+_Static_assert(MLFQ_NUMBER_OF_LEVELS >= 1 && MLFQ_NUMBER_OF_LEVELS <= 32, "the levels with a ready process are kept in the bits of an unsigned int");
+
+// the time slice of level i is TIME_SLICE * time_slice_factors[i]
+static const int time_slice_factors[] = MLFQ_TIME_SLICE_FACTORS;
+_Static_assert(sizeof(time_slice_factors) / sizeof(time_slice_factors[0]) == MLFQ_NUMBER_OF_LEVELS, "MLFQ_TIME_SLICE_FACTORS needs one entry per level");
+
+// everything the threads share. the queues and the bitmap are only touched while the buffer lock is held.
+struct shared_queues
+{
+    struct bounded_buffer buffer;
+    struct run_queue levels[MLFQ_NUMBER_OF_LEVELS];
+    // bit i is set while levels[i] is not empty, so the highest level with a ready process is found with a single count trailing zeros.
+    unsigned int ready_levels;
+    // blocked processes wait per event type and per level, so that when their event happens every level can be moved back in one splice.
+    struct run_queue event_queues[NUMBER_OF_EVENT_TYPES][MLFQ_NUMBER_OF_LEVELS];
+    // when every event type last happened, in nano seconds
+    long long int event_fired_at[NUMBER_OF_EVENT_TYPES];
+};
+
+struct creator_pack
+{
+    struct shared_queues* queues;
+    // number of times the creator took the buffer lock to queue its processes.
+    long int lock_acquisitions;
+};
+
+struct consumer_pack
+{
+    unsigned int consumer_id;
+    struct shared_queues* queues;
+    // every consumer records into its own statistics block, so consumers never write to the same memory. they are merged once the consumer has been joined.
+    struct latency_stats stats;
+    // number of times this consumer ran a process
+    long int dispatches;
+};
+
+struct event_pack
+{
+    struct shared_queues* queues;
+    unsigned int* events_generated;
+    unsigned int* boosts;
+};
+
+static int is_finished(struct process* a_process)
+{
+    return a_process->iState == FINISHED;
+}
+
+static int time_slice_of(int level)
+{
+    return TIME_SLICE * time_slice_factors[level];
+}
+
+// adds the process at the end of the queue of its level. the caller holds the buffer lock.
+static void push_level(struct shared_queues* queues, int level, struct process* a_process)
+{
+    run_queue_push_back(&queues->levels[level], a_process);
+    queues->ready_levels |= 1u << level;
+}
+
+// takes the first process of the highest level that has one. the caller holds the buffer lock, and the buffer says there is a ready process.
+static struct process* pop_highest_level(struct shared_queues* queues, int* level)
+{
+    *level = __builtin_ctz(queues->ready_levels);
+    struct process* a_process = run_queue_pop_front(&queues->levels[*level]);
+    if(run_queue_length(&queues->levels[*level]) == 0)
+        queues->ready_levels &= ~(1u << *level);
+    return a_process;
+}
+
+// moves every process, ready or blocked, back to level 0. the caller holds the buffer lock.
+static void boost(struct shared_queues* queues)
+{
+    int level, event_type;
+    for(level = 1; level < MLFQ_NUMBER_OF_LEVELS; level++)
+    {
+        run_queue_splice(&queues->levels[0], &queues->levels[level]);
+        for(event_type = 0; event_type < NUMBER_OF_EVENT_TYPES; event_type++)
+            run_queue_splice(&queues->event_queues[event_type][0], &queues->event_queues[event_type][level]);
+    }
+    queues->ready_levels = run_queue_length(&queues->levels[0]) > 0 ? 1u : 0u;
+}
+
+static void* create_processes(void* creator_package)
+{
+    struct creator_pack* creator = (struct creator_pack*) creator_package;
+    // the workload is drawn from a random stream of its own, so it is the same in every run whatever the consumers draw.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    struct shared_queues* queues = creator->queues;
+    // the processes that are being queued. the batch size is only known at run time and may be large, so the batch is not on the stack of the thread.
+    // a batch never holds more processes than fit in the buffer.
+    struct process** batch = (struct process**) calloc(SUBMIT_BATCH_SIZE < BUFFER_SIZE ? SUBMIT_BATCH_SIZE : BUFFER_SIZE, sizeof(struct process*));
+    assert(batch != NULL);
+    size_t processes_created = 0;
+    size_t i;
+    while(processes_created < NUMBER_OF_PROCESSES)
+    {
+        size_t batch_size = NUMBER_OF_PROCESSES - processes_created < (size_t) SUBMIT_BATCH_SIZE ? NUMBER_OF_PROCESSES - processes_created : (size_t) SUBMIT_BATCH_SIZE;
+        // a replayed job that has not arrived yet is waited for before taking the lock, so that waiting never holds up the consumers.
+        waitForNextArrival();
+        // sleeps in bounded_buffer_begin_add_batch while the buffer is full, then only generates as many processes as there is space for, so a process never waits outside the buffer once it exists.
+        // generating a process takes no more than a pool allocation and a few random numbers, so it is done while the lock is held.
+        batch_size = bounded_buffer_begin_add_batch(&queues->buffer, batch_size);
+        size_t added = generateProcesses(batch, batch_size);
+        for(i = 0; i < added; i++)
+        {
+            push_level(queues, 0, batch[i]);
+        }
+        bounded_buffer_end_add_batch(&queues->buffer, added);
+        creator->lock_acquisitions++;
+        processes_created += added;
+    }
+    bounded_buffer_close(&queues->buffer);
+    free(batch);
+    pthread_exit(NULL);
+    // Kill the thread. We're done creating processes.
+}
+
+// Makes a random event happen every so often, and boosts the priorities every MLFQ_BOOST_INTERVAL, until every process has finished.
+static void* generate_events(void* event_package)
+{
+    struct event_pack* events = (struct event_pack*) event_package;
+    setRandomStream(RANDOM_STREAM_EVENTS);
+    struct shared_queues* queues = events->queues;
+    struct timeval last_boost, now;
+    gettimeofday(&last_boost, NULL);
+    while(1)
+    {
+        usleep((1 + generateRandomNumber(MAX_EVENT_INTERVAL)) * 1000);
+        int event_type = generateEventType();
+        int level;
+        bounded_buffer_begin_requeue(&queues->buffer);
+        if(bounded_buffer_finished(&queues->buffer))
+        {
+            bounded_buffer_end_requeue(&queues->buffer, 0);
+            break;
+        }
+        gettimeofday(&now, NULL);
+        if(getDifferenceInMilliSeconds(last_boost, now) >= MLFQ_BOOST_INTERVAL)
+        {
+            boost(queues);
+            last_boost = now;
+            (*events->boosts)++;
+        }
+        // everything that was waiting for this event is ready again, at the level it blocked at. every level moves in one go.
+        size_t unblocked = 0;
+        queues->event_fired_at[event_type] = getTimeInNanoSeconds();
+        for(level = 0; level < MLFQ_NUMBER_OF_LEVELS; level++)
+        {
+            struct run_queue* waiting = &queues->event_queues[event_type][level];
+            if(run_queue_length(waiting) == 0)
+                continue;
+            unblocked += run_queue_length(waiting);
+            run_queue_splice(&queues->levels[level], waiting);
+            queues->ready_levels |= 1u << level;
+        }
+        bounded_buffer_end_requeue(&queues->buffer, unblocked);
+        (*events->events_generated)++;
+    }
+    pthread_exit(NULL);
+}
+
+static void* consume_processes(void* consumer_package)
+{
+    struct consumer_pack* consumer = (struct consumer_pack*) consumer_package;
+    // whether a process blocks is drawn from the stream of the consumer that runs it.
+    setRandomStream(RANDOM_STREAM_CONSUMER(consumer->consumer_id));
+    struct shared_queues* queues = consumer->queues;
+    // thread does not die until we're no longer creating more and every process has finished.
+    // while every live process is blocked the thread sleeps in bounded_buffer_begin_take until the event generator wakes it up.
+    while(bounded_buffer_begin_take(&queues->buffer))
+    {
+        // there is a ready process, from here on until it runs the time goes to selecting it.
+        long long int selecting = getTimeInNanoSeconds();
+        int level;
+        struct process* begin = pop_highest_level(queues, &level);
+        // processes that were unblocked are set back to ready here rather than in the event generator, so moving a queue stays O(1).
+        // for the same reason their ready time is that of the last occurrence of their event, which is later than the one that woke them up if the event happened again in the meantime.
+        if(begin->iState == BLOCKED)
+        {
+            begin->iState = READY;
+            begin->iReadySince = queues->event_fired_at[begin->iEventType];
+        }
+        bounded_buffer_end_take(&queues->buffer);
+        struct timeval start, end;
+        int previous_burst = begin->iBurstTime;
+        int already_running = begin->iState != NEW;
+        long long int ready_since = begin->iReadySince;
+        long long int running = getTimeInNanoSeconds();
+        simulateBlockingRoundRobinProcessWithTimeSlice(begin, time_slice_of(level), &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        consumer->dispatches++;
+        unsigned int response_time = getDifferenceInMilliSeconds(begin->oTimeCreated, start);
+        // the writer thread formats and prints the line, the consumer only copies the event into its own ring.
+        trace_log_dispatch(consumer->consumer_id, begin, previous_burst, !already_running, start, end);
+        if(!already_running)
+        {
+            latency_stats_record_response(&consumer->stats, response_time);
+        }
+        if(is_finished(begin))
+        {
+            unsigned int turnaround_time = getDifferenceInMilliSeconds(begin->oTimeCreated, end);
+            latency_stats_record_completion(&consumer->stats, turnaround_time, begin->iInitialBurstTime);
+            process_release(begin);
+            bounded_buffer_retire(&queues->buffer);
+        }
+        else if(begin->iState == BLOCKED)
+        {
+            // blocked before its time slice was up, so it is interactive: one level up, and wait in the queue of its event. no consumer is woken up.
+            if(level > 0)
+                level--;
+            bounded_buffer_begin_requeue(&queues->buffer);
+            run_queue_push_back(&queues->event_queues[begin->iEventType][level], begin);
+            bounded_buffer_end_requeue(&queues->buffer, 0);
+        }
+        else
+        {
+            // used its whole time slice: one level down, at the end of that queue.
+            if(level < MLFQ_NUMBER_OF_LEVELS - 1)
+                level++;
+            bounded_buffer_begin_requeue(&queues->buffer);
+            begin->iReadySince = getTimeInNanoSeconds();
+            push_level(queues, level, begin);
+            bounded_buffer_end_requeue(&queues->buffer, 1);
+        }
+        latency_stats_record_dispatch(&consumer->stats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
+    }
+    pthread_exit(NULL);
+    // Kill the thread.
+}
+
+void run_mlfq_multiple_consumers(struct scheduler_result* result)
+{
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
+    unsigned int events_generated = 0;
+    unsigned int boosts = 0;
+    unsigned int i, j;
+    // TIME_SLICE is only known at run time, every time slice has to be a positive int.
+    for(i = 0; i < MLFQ_NUMBER_OF_LEVELS; i++)
+        assert(time_slice_factors[i] > 0 && TIME_SLICE <= INT_MAX / time_slice_factors[i]);
+    struct shared_queues queues;
+    bounded_buffer_init(&queues.buffer, BUFFER_SIZE);
+    queues.ready_levels = 0;
+    for(i = 0; i < MLFQ_NUMBER_OF_LEVELS; i++)
+    {
+        run_queue_init(&queues.levels[i]);
+        for(j = 0; j < NUMBER_OF_EVENT_TYPES; j++)
+            run_queue_init(&queues.event_queues[j][i]);
+    }
+    for(j = 0; j < NUMBER_OF_EVENT_TYPES; j++)
+        queues.event_fired_at[j] = 0;
+    pthread_t creator_thread_handle, event_thread_handle;
+    pthread_t* consumer_thread_handle = (pthread_t*) calloc(NUMBER_OF_CONSUMERS, sizeof(pthread_t));
+    struct creator_pack creator;
+    creator.queues = &queues;
+    creator.lock_acquisitions = 0;
+    pthread_create(&creator_thread_handle, NULL, create_processes, &creator);
+    struct event_pack events;
+    events.queues = &queues;
+    events.events_generated = &events_generated;
+    events.boosts = &boosts;
+    pthread_create(&event_thread_handle, NULL, generate_events, &events);
+    // the packs are on the heap: each of them holds the latency histograms of its consumer, and hundreds of consumers would not fit on the stack.
+    struct consumer_pack* consumer = (struct consumer_pack*) calloc(NUMBER_OF_CONSUMERS, sizeof(struct consumer_pack));
+    assert(consumer != NULL && consumer_thread_handle != NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        consumer[i].consumer_id = i;
+        consumer[i].queues = &queues;
+        latency_stats_init(&consumer[i].stats);
+        consumer[i].dispatches = 0;
+        pthread_create(&consumer_thread_handle[i], NULL, consume_processes, &consumer[i]);
+    }
+
+    pthread_join(creator_thread_handle, NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        pthread_join(consumer_thread_handle[i], NULL);
+        latency_stats_merge(&result->oStats, &consumer[i].stats);
+        result->iDispatches += consumer[i].dispatches;
+    }
+    pthread_join(event_thread_handle, NULL);
+    bounded_buffer_destroy(&queues.buffer);
+    printf("%d processes submitted in %ld lock acquisitions (%.2f per process)\n", NUMBER_OF_PROCESSES, creator.lock_acquisitions, (double) creator.lock_acquisitions / NUMBER_OF_PROCESSES);
+    printf("%d events generated, %d priority boosts\n", events_generated, boosts);
+    free(consumer);
+    free(consumer_thread_handle);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    run_mlfq_multiple_consumers(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
+    profiled_mutex_print_stats();
+    return 0;
+}
+#endif
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <assert.h>
+#include "mpmc_ring.h"
+
+/*
+ * Initialises an empty ring. The capacity is rounded up to a power of two so that positions can be mapped to cells with a mask.
+ */
+void mpmc_ring_init(struct mpmc_ring * oRing, size_t iCapacity)
+{
+	size_t iSize = 2;
+	size_t i;
+	while(iSize < iCapacity)
+		iSize *= 2;
+	oRing->aCells = (struct mpmc_ring_cell *) aligned_alloc(CACHE_LINE_SIZE, ((iSize * sizeof(struct mpmc_ring_cell) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE);
+	assert(oRing->aCells != NULL);
+	oRing->iMask = iSize - 1;
+	for(i = 0; i < iSize; i++)
+	{
+		atomic_init(&(oRing->aCells[i].iSequence), i);
+		oRing->aCells[i].oProcess = NULL;
+	}
+	atomic_init(&(oRing->iTail), 0);
+	atomic_init(&(oRing->iHead), 0);
+}
+
+void mpmc_ring_destroy(struct mpmc_ring * oRing)
+{
+	free(oRing->aCells);
+	oRing->aCells = NULL;
+}
+
+/*
+ * Appends the process at the tail of the ring. Returns 1 on success, or 0 if the ring is full.
+ */
+int mpmc_ring_enqueue(struct mpmc_ring * oRing, struct process * oTemp)
+{
+	struct mpmc_ring_cell * oCell;
+	size_t iPosition = atomic_load_explicit(&(oRing->iTail), memory_order_relaxed);
+	for(;;)
+	{
+		oCell = &(oRing->aCells[iPosition & oRing->iMask]);
+		size_t iSequence = atomic_load_explicit(&(oCell->iSequence), memory_order_acquire);
+		long int iDifference = (long int) iSequence - (long int) iPosition;
+		if(iDifference == 0)
+		{
+			// the cell is free for this lap, claim it by moving the tail
+			if(atomic_compare_exchange_weak_explicit(&(oRing->iTail), &iPosition, iPosition + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		else if(iDifference < 0)
+			return 0;
+		else
+			iPosition = atomic_load_explicit(&(oRing->iTail), memory_order_relaxed);
+	}
+	oCell->oProcess = oTemp;
+	// publish the process to the consumers
+	atomic_store_explicit(&(oCell->iSequence), iPosition + 1, memory_order_release);
+	return 1;
+}
+
+/*
+ * Removes the process at the head of the ring. Returns NULL if the ring is empty.
+ * Note that NULL can also be returned for a short moment while a producer that claimed the head cell has not published its process yet.
+ */
+struct process * mpmc_ring_dequeue(struct mpmc_ring * oRing)
+{
+	struct mpmc_ring_cell * oCell;
+	size_t iPosition = atomic_load_explicit(&(oRing->iHead), memory_order_relaxed);
+	for(;;)
+	{
+		oCell = &(oRing->aCells[iPosition & oRing->iMask]);
+		size_t iSequence = atomic_load_explicit(&(oCell->iSequence), memory_order_acquire);
+		long int iDifference = (long int) iSequence - (long int) (iPosition + 1);
+		if(iDifference == 0)
+		{
+			if(atomic_compare_exchange_weak_explicit(&(oRing->iHead), &iPosition, iPosition + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		else if(iDifference < 0)
+			return NULL;
+		else
+			iPosition = atomic_load_explicit(&(oRing->iHead), memory_order_relaxed);
+	}
+	struct process * oTemp = oCell->oProcess;
+	// hand the cell back to the producers for their next lap
+	atomic_store_explicit(&(oCell->iSequence), iPosition + oRing->iMask + 1, memory_order_release);
+	return oTemp;
+}
@@ -0,0 +1,33 @@
+#ifndef MPMC_RING_H
+#define MPMC_RING_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "posix_utility.h"
+
+/*
+ * Fixed capacity, lock-free, multi-producer/multi-consumer FIFO ring of process pointers (Dmitry Vyukov's bounded queue).
+ * Every cell carries a sequence number telling producers and consumers whether it is free or holds a published process for their lap around the ring,
+ * so enqueue and dequeue are a single compare-and-swap on the tail or head index.
+ * The head and tail indices sit on their own cache lines so that producers and consumers do not invalidate each other's line.
+ */
+struct mpmc_ring_cell
+{
+	atomic_size_t iSequence;
+	struct process * oProcess;
+};
+
+struct mpmc_ring
+{
+	struct mpmc_ring_cell * aCells;
+	size_t iMask;
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t iTail;
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t iHead;
+};
+
+void mpmc_ring_init(struct mpmc_ring * oRing, size_t iCapacity);
+void mpmc_ring_destroy(struct mpmc_ring * oRing);
+int mpmc_ring_enqueue(struct mpmc_ring * oRing, struct process * oTemp);
+struct process * mpmc_ring_dequeue(struct mpmc_ring * oRing);
+
+#endif
@@ -1,30 +1,214 @@
 #include <stdlib.h>
 #include <sys/time.h>
+#include <time.h>
+#include <pthread.h>
 #include "posix_utility.h"
+#include "process_pool.h"
+#include "workload_trace.h"
+#include "child_process.h"
 #include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/timerfd.h>
+#if USE_TSC_CLOCK && (defined(__x86_64__) || defined(__i386__))
+#define TSC_CLOCK 1
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 
-int iPid = 0;
+// process ids are handed out atomically, so several creators can generate processes at the same time
+static atomic_int iPid = 0;
 
+/*
+ * Every thread draws its random numbers from a xoshiro256** stream of its own, so drawing never takes a lock and the threads do not disturb each other's sequence.
+ * The streams are derived from one master seed: a thread that selected stream i with setRandomStream always gets the same sequence for the same seed, whatever the other threads do.
+ * A thread that never selects a stream gets the next unused one the first time it draws. setRandomSeed starts every stream from the beginning again.
+ */
+static uint64_t iMasterSeed = RANDOM_SEED;
+// bumped by setRandomSeed, a thread whose stream is of an older generation seeds it again before it draws
+static atomic_uint iRandomGeneration = 1;
+static atomic_int iNextAnonymousStream = RANDOM_STREAM_ANONYMOUS;
+static __thread uint64_t aRandomState[4];
+static __thread unsigned int iThreadRandomGeneration = 0;
+static __thread int iThreadRandomStream = -1;
+
+struct scheduler_parameters oSchedulerParameters = {DEFAULT_TIME_SLICE, DEFAULT_NUMBER_OF_PROCESSES, DEFAULT_BUFFER_SIZE, DEFAULT_NUMBER_OF_CONSUMERS, DEFAULT_SUBMIT_BATCH_SIZE, DEFAULT_FORKED_PROCESSES, DEFAULT_BURST_MODE};
+
+/*
+ * Every thread has its own simulation mode and virtual clock, so that a discrete-event simulation running on one thread does not affect the others.
+ */
+static __thread int iSimulationMode = REAL_TIME;
+static __thread struct timeval oVirtualTime;
+
+
+/*
+ * Takes the next job of the workload trace that is being replayed. In REAL_TIME mode the process is only created once its arrival time has come, and that is its creation time,
+ * so time the creator spends waiting for space in the buffer counts towards the response time. In VIRTUAL_TIME mode the simulation decides when processes arrive, and the arrival times are not used.
+ */
+static void replayProcess(struct process * oTemp)
+{
+	struct workload_record oRecord;
+	struct timeval oArrivalTime, oNow;
+	int iReplayed = workload_trace_next(&oRecord, &oArrivalTime);
+	assert(iReplayed);
+	oTemp->iBurstTime = oRecord.iBurstTime;
+	oTemp->iPriority = oRecord.iPriority;
+	oTemp->iBlockingProbability = oRecord.iBlockingProbability;
+	if(iSimulationMode == VIRTUAL_TIME)
+	{
+		getCurrentTime(&(oTemp->oTimeCreated));
+		return;
+	}
+	gettimeofday(&oNow, NULL);
+	long int iWait = (oArrivalTime.tv_sec - oNow.tv_sec) * 1000000L + (oArrivalTime.tv_usec - oNow.tv_usec);
+	if(iWait > 0)
+		usleep(iWait);
+	oTemp->oTimeCreated = oArrivalTime;
+}
 
 /*
  * Function generates asingle job and initialise the fields. Processs will have a increasing job id, reflecting the order in which they were created.
- * Note that the objects returned are allocated in dynamic memory, and that the caller is responsible for free-ing the memory when it is no longer in use.  
+ * While a workload trace is open the job is taken from the trace instead, see 'workload_trace.h'.
+ * Note that the objects returned come from the process pool, and that the caller is responsible for handing them back with process_release once they have finished.
  *
  * REMARK: note that the random generator will generate a fixed sequence of random numbers. I.e., every time the code is run, the times that are generated will be the same, although the individual 
- * numbers themselves are "random". This is achieved by seeding the generator (by default), and is done to facilitate debugging if necessary.
+ * numbers themselves are "random". This is achieved by deriving the stream of every thread from RANDOM_SEED (see generateRandomNumber), and is done to facilitate debugging if necessary.
  */
 struct process * generateProcess()
 {	
-	struct process * oTemp = (struct process *) malloc (sizeof(struct process));
-	oTemp->iProcessId = iPid++;
-	oTemp->iBurstTime = (rand() % MAX_BURST_TIME) + 1;
-	gettimeofday(&(oTemp->oTimeCreated), NULL);
+	struct process * oTemp = process_alloc();
+	oTemp->iProcessId = allocateProcessId();
+	if(workload_trace_active())
+	{
+		replayProcess(oTemp);
+	}
+	else
+	{
+		oTemp->iBurstTime = generateRandomNumber(MAX_BURST_TIME) + 1;
+		oTemp->iPriority = 0;
+		oTemp->iBlockingProbability = BLOCKING_PROBABILITY;
+		getCurrentTime(&(oTemp->oTimeCreated));
+	}
+	oTemp->iInitialBurstTime = oTemp->iBurstTime;
+	oTemp->iNice = oTemp->iPriority < -20 ? -20 : (oTemp->iPriority > 19 ? 19 : oTemp->iPriority);
+	oTemp->iVirtualRuntime = 0;
+	oTemp->oDeadline.tv_sec = 0;
+	oTemp->oDeadline.tv_usec = 0;
+	oTemp->iRelativeDeadline = 0;
+	oTemp->iPeriod = 0;
+	oTemp->iCpu = -1;
+	oTemp->iReadySince = getTimeInNanoSeconds();
+	oTemp->iChild = 0;
 	oTemp->iState = NEW;
 	oTemp->iEventType = -1;
+	oTemp->iHeapIndex = -1;
 	oTemp->oNext = NULL;
+	oTemp->oPrev = NULL;
 	return oTemp;
 }
 
+/*
+ * Returns the time in micro seconds until the next job of the workload trace that is being replayed arrives, 0 if it has arrived already or no trace is replayed in real time.
+ */
+static long int timeUntilNextArrival()
+{
+	struct timeval oArrivalTime, oNow;
+	if(!workload_trace_active() || iSimulationMode == VIRTUAL_TIME || !workload_trace_next_arrival(&oArrivalTime))
+		return 0;
+	gettimeofday(&oNow, NULL);
+	long int iWait = (oArrivalTime.tv_sec - oNow.tv_sec) * 1000000L + (oArrivalTime.tv_usec - oNow.tv_usec);
+	return iWait > 0 ? iWait : 0;
+}
+
+/*
+ * Generates up to iWanted processes into aBatch without ever waiting, and returns how many it generated. Random processes can always be generated,
+ * but a job of a workload trace is only taken once it has arrived, so the batch is empty while the next job has not arrived yet. Can therefore be called with a lock held.
+ */
+size_t generateProcesses(struct process ** aBatch, size_t iWanted)
+{
+	size_t iGenerated = 0;
+	while(iGenerated < iWanted && timeUntilNextArrival() == 0)
+		aBatch[iGenerated++] = generateProcess();
+	return iGenerated;
+}
+
+/*
+ * Sleeps until the next job of the workload trace that is being replayed has arrived, so that generateProcesses has at least one process to generate. Returns at once when random processes are generated.
+ */
+void waitForNextArrival()
+{
+	long int iWait = timeUntilNextArrival();
+	if(iWait > 0)
+		usleep(iWait);
+}
+
+static long long int getMonotonicNanoSeconds()
+{
+	struct timespec oNow;
+	clock_gettime(CLOCK_MONOTONIC, &oNow);
+	return oNow.tv_sec * 1000000000LL + oNow.tv_nsec;
+}
+
+#ifdef TSC_CLOCK
+/*
+ * The time stamp counter is only used when it is invariant, i.e. it ticks at a constant rate whatever the frequency and power state of the core, and is in step on every core.
+ * Its rate is measured once against CLOCK_MONOTONIC, and a reading is converted to a CLOCK_MONOTONIC time from there.
+ */
+static pthread_once_t oTscCalibration = PTHREAD_ONCE_INIT;
+static int iTscUsable = 0;
+static unsigned long long int iTscBase;
+static long long int iNanoSecondsBase;
+static double dNanoSecondsPerTick;
+
+static void calibrateTsc()
+{
+	unsigned int iEax, iEbx, iEcx, iEdx;
+	if(!__get_cpuid(0x80000007, &iEax, &iEbx, &iEcx, &iEdx) || !(iEdx & (1u << 8)))
+		return;
+	iNanoSecondsBase = getMonotonicNanoSeconds();
+	iTscBase = __rdtsc();
+	// 10 milli seconds is enough to get the rate right to a few parts per million
+	long long int iNanoSecondsEnd;
+	do
+		iNanoSecondsEnd = getMonotonicNanoSeconds();
+	while(iNanoSecondsEnd - iNanoSecondsBase < 10000000LL);
+	unsigned long long int iTscEnd = __rdtsc();
+	dNanoSecondsPerTick = (double) (iNanoSecondsEnd - iNanoSecondsBase) / (double) (iTscEnd - iTscBase);
+	iTscUsable = 1;
+}
+#endif
+
+/*
+ * Returns a monotonic time stamp in nano seconds, for measuring the scheduler's own overhead, which is well below the milli second resolution of getDifferenceInMilliSeconds.
+ * The time is that of CLOCK_MONOTONIC, also when it is read from the time stamp counter (USE_TSC_CLOCK). It is unrelated to gettimeofday and to the virtual clock of a simulation.
+ */
+long long int getTimeInNanoSeconds()
+{
+#ifdef TSC_CLOCK
+	pthread_once(&oTscCalibration, calibrateTsc);
+	if(iTscUsable)
+		return iNanoSecondsBase + (long long int) ((double) (__rdtsc() - iTscBase) * dNanoSecondsPerTick);
+#endif
+	return getMonotonicNanoSeconds();
+}
+
+/*
+ * Names the clock getTimeInNanoSeconds reads, "tsc" or "monotonic".
+ */
+const char * getClockSource()
+{
+#ifdef TSC_CLOCK
+	pthread_once(&oTscCalibration, calibrateTsc);
+	if(iTscUsable)
+		return "tsc";
+#endif
+	return "monotonic";
+}
+
 /*
  * Function returning the time difference in milliseconds between the two time stamps, with start being the earlier time, and end being the later time.
  */
@@ -36,6 +220,26 @@ long int getDifferenceInMilliSeconds(struct timeval start, struct timeval end)
 	return mtime;
 }
 
+/*
+ * Runs the process for iBurstTime milli seconds: its forked child gets that much CPU time in FORKED_PROCESSES mode, otherwise runProcess spins for it.
+ */
+static void runJob(struct process * oTemp, int iBurstTime, struct timeval * oStartTime, struct timeval * oEndTime)
+{
+	if(FORKED_PROCESSES && iSimulationMode == REAL_TIME)
+		child_process_run(oTemp, iBurstTime, oStartTime, oEndTime);
+	else
+		runProcess(iBurstTime, oStartTime, oEndTime);
+}
+
+/*
+ * Marks the process as finished, and gets rid of its child if it has one.
+ */
+static void finishJob(struct process * oTemp)
+{
+	oTemp->iState = FINISHED;
+	child_process_end(oTemp);
+}
+
 /*
  * Function to call when simulating a SJF job. This function will:
  * - change the state to running
@@ -45,11 +249,10 @@ long int getDifferenceInMilliSeconds(struct timeval start, struct timeval end)
  */
 void simulateSJFProcess(struct process * oTemp, struct timeval * oStartTime, struct timeval * oEndTime)
 {
-	long int iDifference = 0;
 	oTemp->iState = RUNNING;
-	runProcess(oTemp->iBurstTime, oStartTime, oEndTime);
+	runJob(oTemp, oTemp->iBurstTime, oStartTime, oEndTime);
 	oTemp->iBurstTime = 0;
-	oTemp->iState = FINISHED;
+	finishJob(oTemp);
 }
 
 /*
@@ -62,14 +265,21 @@ void simulateSJFProcess(struct process * oTemp, struct timeval * oStartTime, str
  */
 void simulateRoundRobinProcess(struct process * oTemp, struct timeval * oStartTime, struct timeval * oEndTime)
 {
-	long int iDifference = 0;
-	int iBurstTime = oTemp->iBurstTime > TIME_SLICE ? TIME_SLICE : oTemp->iBurstTime;
+	simulateRoundRobinProcessWithTimeSlice(oTemp, TIME_SLICE, oStartTime, oEndTime);
+}
+
+/*
+ * Same as simulateRoundRobinProcess, with a time slice of iTimeSlice instead of TIME_SLICE, for schedulers that give different processes different time slices.
+ */
+void simulateRoundRobinProcessWithTimeSlice(struct process * oTemp, int iTimeSlice, struct timeval * oStartTime, struct timeval * oEndTime)
+{
+	int iBurstTime = oTemp->iBurstTime > iTimeSlice ? iTimeSlice : oTemp->iBurstTime;
 	oTemp->iState = RUNNING;
-	runProcess(iBurstTime, oStartTime, oEndTime);
+	runJob(oTemp, iBurstTime, oStartTime, oEndTime);
 	oTemp->iBurstTime -= iBurstTime;
 	if(oTemp->iBurstTime == 0)
-		oTemp->iState = FINISHED;
-	else if (iBurstTime == TIME_SLICE)
+		finishJob(oTemp);
+	else if (iBurstTime == iTimeSlice)
 		oTemp->iState = READY;
 }
 
@@ -86,34 +296,122 @@ void simulateRoundRobinProcess(struct process * oTemp, struct timeval * oStartTi
  */
 void simulateBlockingRoundRobinProcess(struct process * oTemp, struct timeval * oStartTime, struct timeval * oEndTime)
 {
-	int iBurstTime = generateBurstTime(oTemp);
+	simulateBlockingRoundRobinProcessWithTimeSlice(oTemp, TIME_SLICE, oStartTime, oEndTime);
+}
+
+/*
+ * Same as simulateBlockingRoundRobinProcess, with a time slice of iTimeSlice instead of TIME_SLICE.
+ */
+void simulateBlockingRoundRobinProcessWithTimeSlice(struct process * oTemp, int iTimeSlice, struct timeval * oStartTime, struct timeval * oEndTime)
+{
+	int iBurstTime = generateBurstTimeWithTimeSlice(oTemp, iTimeSlice);
 	oTemp->iState = RUNNING;
-	runProcess(iBurstTime, oStartTime, oEndTime);
+	runJob(oTemp, iBurstTime, oStartTime, oEndTime);
 	oTemp->iBurstTime -= iBurstTime;
 	if(oTemp->iBurstTime == 0)
-		oTemp->iState = FINISHED;
-	else if (iBurstTime == TIME_SLICE)
+		finishJob(oTemp);
+	else if (iBurstTime == iTimeSlice)
 		oTemp->iState = READY;
-	else if (iBurstTime < TIME_SLICE)
+	else if (iBurstTime < iTimeSlice)
 	{
 		oTemp->iEventType = generateEventType();
 		oTemp->iState = BLOCKED;	
 	}
 }
 
+/*
+ * Every thread that runs processes in BURST_TIMERFD mode has a timer of its own. It is created the first time the thread needs it and closed when the thread exits.
+ */
+static pthread_once_t oBurstTimerKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t oBurstTimerKey;
+static __thread int iBurstTimer = -1;
+
+static void closeBurstTimer(void * pTimer)
+{
+	close((int) (intptr_t) pTimer - 1);
+}
+
+static void createBurstTimerKey()
+{
+	pthread_key_create(&oBurstTimerKey, closeBurstTimer);
+}
+
+/*
+ * Sleeps until iEnd on CLOCK_MONOTONIC, in nano seconds, either in clock_nanosleep or reading an absolute timerfd.
+ */
+static void sleepUntil(long long int iEnd, int iMode)
+{
+	struct timespec oEnd = {iEnd / 1000000000LL, iEnd % 1000000000LL};
+	if(iMode == BURST_SLEEP)
+	{
+		// a signal only interrupts the sleep, the deadline stays the same
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &oEnd, NULL) == EINTR)
+			;
+		return;
+	}
+	if(iBurstTimer < 0)
+	{
+		pthread_once(&oBurstTimerKeyOnce, createBurstTimerKey);
+		iBurstTimer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+		assert(iBurstTimer >= 0);
+		pthread_setspecific(oBurstTimerKey, (void *) (intptr_t) (iBurstTimer + 1));
+	}
+	struct itimerspec oTimer;
+	memset(&oTimer, 0, sizeof(oTimer));
+	oTimer.it_value = oEnd;
+	int iSet = timerfd_settime(iBurstTimer, TFD_TIMER_ABSTIME, &oTimer, NULL);
+	assert(iSet == 0);
+	uint64_t iExpirations;
+	while(read(iBurstTimer, &iExpirations, sizeof(iExpirations)) < 0 && errno == EINTR)
+		;
+}
+
+static const char * aBurstModeNames[] = {"spin", "sleep", "timerfd"};
+
+const char * getBurstModeName(int iMode)
+{
+	return aBurstModeNames[iMode];
+}
+
+/*
+ * Returns the burst mode with the given name, or -1 if there is none.
+ */
+int parseBurstMode(const char * sName)
+{
+	int i;
+	for(i = 0; i < (int) (sizeof(aBurstModeNames) / sizeof(aBurstModeNames[0])); i++)
+	{
+		if(strcmp(sName, aBurstModeNames[i]) == 0)
+			return i;
+	}
+	return -1;
+}
+
 /*
  * Simulates the job running on a CPU for a number of milli seconds
+ * In VIRTUAL_TIME mode, nothing runs: the job starts at the current virtual time and the virtual clock is moved forward by the burst time.
+ * In REAL_TIME mode the calling thread spins or sleeps until the end of the burst, depending on BURST_MODE. The end is an absolute time, so a late wake up does not add up over the bursts of a process.
  */
 void runProcess(int iBurstTime, struct timeval * oStartTime, struct timeval * oEndTime)
 {
-	struct timeval oCurrent;
-	long int iDifference = 0;
+	if(iSimulationMode == VIRTUAL_TIME)
+	{
+		*oStartTime = oVirtualTime;
+		addMilliSeconds(&oVirtualTime, iBurstTime);
+		*oEndTime = oVirtualTime;
+		return;
+	}
+	// the burst is timed on the monotonic clock, so a step of the wall clock does not make the process run shorter or longer. the time stamps stay wall clock times, like oTimeCreated.
+	int iMode = BURST_MODE;
 	gettimeofday(oStartTime, NULL);
-	do
-	{	
-		gettimeofday(&oCurrent, NULL);
-		iDifference = getDifferenceInMilliSeconds((*oStartTime), oCurrent);
-	} while(iDifference < iBurstTime);
+	if(iMode == BURST_SPIN)
+	{
+		long long int iEnd = getTimeInNanoSeconds() + iBurstTime * 1000000LL;
+		while(getTimeInNanoSeconds() < iEnd)
+			;
+	}
+	else
+		sleepUntil(getMonotonicNanoSeconds() + iBurstTime * 1000000LL, iMode);
 	gettimeofday(oEndTime, NULL);
 }
 
@@ -123,9 +421,14 @@ void runProcess(int iBurstTime, struct timeval * oStartTime, struct timeval * oE
  */
 int generateBurstTime(struct process * oTemp)
 {
-	int iMaxBurstTime = oTemp->iBurstTime > TIME_SLICE ? TIME_SLICE : oTemp->iBurstTime;
-	if(rand() % 100 < BLOCKING_PROBABILITY)
-		return rand() % iMaxBurstTime;
+	return generateBurstTimeWithTimeSlice(oTemp, TIME_SLICE);
+}
+
+int generateBurstTimeWithTimeSlice(struct process * oTemp, int iTimeSlice)
+{
+	int iMaxBurstTime = oTemp->iBurstTime > iTimeSlice ? iTimeSlice : oTemp->iBurstTime;
+	if(generateRandomNumber(100) < oTemp->iBlockingProbability)
+		return generateRandomNumber(iMaxBurstTime);
 	return iMaxBurstTime;
 }
 
@@ -134,5 +437,211 @@ int generateBurstTime(struct process * oTemp)
  */
 int generateEventType()
 {
-	return rand() % NUMBER_OF_EVENT_TYPES;
+	return generateRandomNumber(NUMBER_OF_EVENT_TYPES);
+}
+
+/*
+ * Hands out the next process id. Ids are unique and increasing in the order in which they were allocated, also when several threads allocate them.
+ */
+int allocateProcessId()
+{
+	return atomic_fetch_add_explicit(&iPid, 1, memory_order_relaxed);
+}
+
+/*
+ * Starts the process ids at 0 again, e.g. before the next run of a benchmark. Only call it while no scheduler is running.
+ */
+void resetProcessIds()
+{
+	atomic_store(&iPid, 0);
+}
+
+// splitmix64, used to spread the master seed and a stream number over the 256 bits of a xoshiro256** state
+static uint64_t splitMix64(uint64_t * iState)
+{
+	uint64_t iValue = (*iState += 0x9E3779B97F4A7C15ULL);
+	iValue = (iValue ^ (iValue >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	iValue = (iValue ^ (iValue >> 27)) * 0x94D049BB133111EBULL;
+	return iValue ^ (iValue >> 31);
+}
+
+static void seedRandomStream()
+{
+	uint64_t iState = iMasterSeed ^ ((uint64_t) iThreadRandomStream * 0xD1B54A32D192ED03ULL);
+	int i;
+	for(i = 0; i < 4; i++)
+		aRandomState[i] = splitMix64(&iState);
+	iThreadRandomGeneration = atomic_load_explicit(&iRandomGeneration, memory_order_acquire);
+}
+
+static uint64_t rotateLeft(uint64_t iValue, int iBits)
+{
+	return (iValue << iBits) | (iValue >> (64 - iBits));
+}
+
+/*
+ * Returns a random number in [0, iBound[, from the stream of the calling thread.
+ */
+int generateRandomNumber(int iBound)
+{
+	assert(iBound > 0);
+	if(iThreadRandomGeneration != atomic_load_explicit(&iRandomGeneration, memory_order_acquire))
+	{
+		if(iThreadRandomStream < 0)
+			iThreadRandomStream = atomic_fetch_add_explicit(&iNextAnonymousStream, 1, memory_order_relaxed);
+		seedRandomStream();
+	}
+	// xoshiro256**
+	uint64_t iResult = rotateLeft(aRandomState[1] * 5, 7) * 9;
+	uint64_t iShifted = aRandomState[1] << 17;
+	aRandomState[2] ^= aRandomState[0];
+	aRandomState[3] ^= aRandomState[1];
+	aRandomState[1] ^= aRandomState[2];
+	aRandomState[0] ^= aRandomState[3];
+	aRandomState[2] ^= iShifted;
+	aRandomState[3] = rotateLeft(aRandomState[3], 45);
+	// the upper 32 bits scaled to the bound, without a division
+	return (int) (((iResult >> 32) * (uint64_t) iBound) >> 32);
+}
+
+/*
+ * Makes the calling thread draw from stream iStream (see RANDOM_STREAM_CREATOR and the others), starting at its beginning.
+ */
+void setRandomStream(int iStream)
+{
+	iThreadRandomStream = iStream;
+	seedRandomStream();
+}
+
+/*
+ * Changes the master seed and starts every stream from the beginning again. Only call it while no scheduler is running.
+ */
+void setRandomSeed(unsigned long long int iSeed)
+{
+	iMasterSeed = iSeed;
+	atomic_store(&iNextAnonymousStream, RANDOM_STREAM_ANONYMOUS);
+	atomic_fetch_add_explicit(&iRandomGeneration, 1, memory_order_release);
+}
+
+/*
+ * Selects REAL_TIME or VIRTUAL_TIME for the calling thread. Switching to VIRTUAL_TIME resets the thread's virtual clock to 0.
+ */
+void setSimulationMode(int iMode)
+{
+	iSimulationMode = iMode;
+	oVirtualTime.tv_sec = 0;
+	oVirtualTime.tv_usec = 0;
+}
+
+int getSimulationMode()
+{
+	return iSimulationMode;
+}
+
+/*
+ * Returns the wall clock time in REAL_TIME mode, and the virtual clock of the calling thread in VIRTUAL_TIME mode.
+ */
+void getCurrentTime(struct timeval * oTime)
+{
+	if(iSimulationMode == VIRTUAL_TIME)
+		*oTime = oVirtualTime;
+	else
+		gettimeofday(oTime, NULL);
+}
+
+/*
+ * Moves the virtual clock of the calling thread, used by the event loop of a discrete-event simulation to jump to the time of the next event.
+ */
+void setVirtualTime(struct timeval oTime)
+{
+	oVirtualTime = oTime;
+}
+
+void addMilliSeconds(struct timeval * oTime, long int iMilliSeconds)
+{
+	oTime->tv_sec += iMilliSeconds / 1000;
+	oTime->tv_usec += (iMilliSeconds % 1000) * 1000;
+	if(oTime->tv_usec >= 1000000)
+	{
+		oTime->tv_sec++;
+		oTime->tv_usec -= 1000000;
+	}
+}
+
+void run_queue_init(struct run_queue * oQueue)
+{
+	oQueue->oHead = NULL;
+	oQueue->oTail = NULL;
+	oQueue->iLength = 0;
+}
+
+/*
+ * Returns the number of processes in the queue. The length is kept up to date by every operation, so there is no need to walk the list.
+ */
+size_t run_queue_length(const struct run_queue * oQueue)
+{
+	return oQueue->iLength;
+}
+
+/*
+ * Appends the process at the tail of the queue.
+ */
+void run_queue_push_back(struct run_queue * oQueue, struct process * oTemp)
+{
+	oTemp->oNext = NULL;
+	oTemp->oPrev = oQueue->oTail;
+	if(oQueue->oTail == NULL)
+		oQueue->oHead = oTemp;
+	else
+		oQueue->oTail->oNext = oTemp;
+	oQueue->oTail = oTemp;
+	oQueue->iLength++;
+}
+
+/*
+ * Removes and returns the process at the head of the queue, or NULL if the queue is empty.
+ */
+struct process * run_queue_pop_front(struct run_queue * oQueue)
+{
+	struct process * oTemp = oQueue->oHead;
+	if(oTemp != NULL)
+		run_queue_unlink(oQueue, oTemp);
+	return oTemp;
+}
+
+/*
+ * Removes a process from anywhere in the queue. The process must currently be in this queue.
+ */
+void run_queue_unlink(struct run_queue * oQueue, struct process * oTemp)
+{
+	if(oTemp->oPrev == NULL)
+		oQueue->oHead = oTemp->oNext;
+	else
+		oTemp->oPrev->oNext = oTemp->oNext;
+	if(oTemp->oNext == NULL)
+		oQueue->oTail = oTemp->oPrev;
+	else
+		oTemp->oNext->oPrev = oTemp->oPrev;
+	oTemp->oNext = NULL;
+	oTemp->oPrev = NULL;
+	oQueue->iLength--;
+}
+
+/*
+ * Moves every process of oSource to the tail of oDestination, keeping their order, in O(1). oSource is empty afterwards.
+ */
+void run_queue_splice(struct run_queue * oDestination, struct run_queue * oSource)
+{
+	if(oSource->oHead == NULL)
+		return;
+	if(oDestination->oTail == NULL)
+		oDestination->oHead = oSource->oHead;
+	else
+	{
+		oDestination->oTail->oNext = oSource->oHead;
+		oSource->oHead->oPrev = oDestination->oTail;
+	}
+	oDestination->oTail = oSource->oTail;
+	oDestination->iLength += oSource->iLength;
+	run_queue_init(oSource);
 }
@@ -1,16 +1,52 @@
+#ifndef POSIX_UTILITY_H
+#define POSIX_UTILITY_H
+
+#include <stddef.h>
 #include <sys/time.h>
 
 // Duration of the time slice for the round robin algorithm
-#define TIME_SLICE 5
+#define DEFAULT_TIME_SLICE 5
 
 // Number of processes to create
-#define NUMBER_OF_PROCESSES 10
+#define DEFAULT_NUMBER_OF_PROCESSES 10
 
 // size of the bounded buffer for task 2 onwards
-#define BUFFER_SIZE 5
+#define DEFAULT_BUFFER_SIZE 5
 
 // number of consumers to use from task 3 onwards
-#define NUMBER_OF_CONSUMERS 5
+#define DEFAULT_NUMBER_OF_CONSUMERS 5
+
+// number of processes the creator of a bounded buffer scheduler generates before it takes the buffer lock and queues them all at once. 1 queues every process on its own
+#define DEFAULT_SUBMIT_BATCH_SIZE 4
+
+// 1 to back every process with a real forked child that is stopped and continued with signals, see 'child_process.h'. 0 to spin in the consumer for the burst time
+#define DEFAULT_FORKED_PROCESSES 0
+
+// how runProcess passes the burst time in real time: spinning keeps a core busy like a real job would, sleeping (clock_nanosleep, or a timerfd of the consumer) until the end of the burst leaves the core free,
+// so that there can be many more consumers than cores and only the cost of the scheduler itself is measured
+#define BURST_SPIN 0
+#define BURST_SLEEP 1
+#define BURST_TIMERFD 2
+#define DEFAULT_BURST_MODE BURST_SPIN
+
+// the schedulers read these from oSchedulerParameters, which starts out with the defaults above and can be changed at run time (e.g. by the benchmark driver)
+#define TIME_SLICE (oSchedulerParameters.iTimeSlice)
+#define NUMBER_OF_PROCESSES (oSchedulerParameters.iNumberOfProcesses)
+#define BUFFER_SIZE (oSchedulerParameters.iBufferSize)
+#define NUMBER_OF_CONSUMERS (oSchedulerParameters.iNumberOfConsumers)
+#define SUBMIT_BATCH_SIZE (oSchedulerParameters.iSubmitBatchSize)
+#define FORKED_PROCESSES (oSchedulerParameters.iForkedProcesses)
+#define BURST_MODE (oSchedulerParameters.iBurstMode)
+
+// master seed of the random streams, see generateRandomNumber
+#define RANDOM_SEED 1
+
+// random streams of the threads of a scheduler. a thread that selects its stream with setRandomStream draws the same numbers in every run, whatever the other threads do
+#define RANDOM_STREAM_CREATOR 0
+#define RANDOM_STREAM_EVENTS 1
+#define RANDOM_STREAM_CONSUMER(iConsumerId) (2 + (iConsumerId))
+// threads that do not select a stream get one from here on
+#define RANDOM_STREAM_ANONYMOUS (1 << 20)
 
 // maximum duration of the individual processes, in milli seconds. Note that the times themselves will be chosen at random in ]0,100]
 #define MAX_BURST_TIME 100 
@@ -21,6 +57,73 @@
 // probability (percent) that a process will block
 #define BLOCKING_PROBABILITY 20
 
+// size of a cache line, used to keep data written by different threads apart
+#define CACHE_LINE_SIZE 64
+
+// maximum time, in milli seconds, between two occurrences of the same event type (task 5)
+#define MAX_EVENT_INTERVAL 20
+
+// number of priority levels of the multilevel feedback queue, at most 32
+#define MLFQ_NUMBER_OF_LEVELS 4
+
+// time slice of every level of the multilevel feedback queue as a multiple of TIME_SLICE, from the highest level to the lowest, so the lower levels run long jobs in longer turns. one entry per level
+#define MLFQ_TIME_SLICE_FACTORS {1, 2, 4, 8}
+
+// time, in milli seconds, between two priority boosts of the multilevel feedback queue, which move every process back to the highest level
+#define MLFQ_BOOST_INTERVAL 100
+
+// period, in milli seconds, in which the fair scheduler wants every runnable process to have run once. a process gets a part of it in proportion to its weight
+#define CFS_TARGET_LATENCY 20
+
+// shortest time slice, in milli seconds, of the fair scheduler, however many processes are runnable
+#define CFS_MIN_GRANULARITY 2
+
+// utilization (percent) of all consumers together that the periodic task set of the EDF scheduler asks for
+#define EDF_UTILIZATION 70
+
+// number of times every periodic task of the EDF scheduler is released
+#define EDF_RELEASES_PER_TASK 4
+
+// 1 to pin consumer i of the per-CPU scheduler to CPU i (modulo the number of CPUs), 0 to let the threads float
+#define PER_CPU_PINNING 1
+
+// time, in milli seconds, between two rounds of the load balancer of the per-CPU scheduler
+#define LOAD_BALANCE_INTERVAL 10
+
+// difference in length between the longest and the shortest run queue from which the load balancer migrates processes
+#define LOAD_BALANCE_THRESHOLD 2
+
+// time, in milli seconds, a process loses the first time it runs on another CPU than before, for its cache and TLB to warm up again
+#define MIGRATION_COST 1
+
+// number of processes to simulate in the discrete-event (virtual time) mode
+#define SIMULATION_NUMBER_OF_PROCESSES 1000000
+
+// 1 to read getTimeInNanoSeconds from the time stamp counter when the CPU has an invariant one, which is cheaper than a clock_gettime call. 0 always uses CLOCK_MONOTONIC
+#define USE_TSC_CLOCK 0
+
+// 1 to make the program sjf_bounded_multiple_consumers preemptive, i.e. shortest remaining time first. the benchmark runs both, as sjf_bounded_multiple_consumers and srtf_multiple_consumers
+#define PREEMPTIVE_SJF 0
+
+// how often, in milli seconds, a preemptive SJF consumer looks whether a shorter process has been given to it while it runs one
+#define PREEMPTION_CHECK_INTERVAL 1
+
+// 1 to count the acquisitions of the ready queue locks and measure how long they are waited for and held, per call site, see 'profiled_mutex.h'. 0 makes them plain mutexes
+#define LOCK_PROFILING 1
+
+// runProcess either passes the burst time as set by BURST_MODE (real time) or advances the thread's virtual clock (discrete-event simulation)
+#define REAL_TIME 0
+#define VIRTUAL_TIME 1
+
+// format of the dispatch trace the schedulers write in the background
+#define TRACE_TEXT 0
+#define TRACE_CSV 1
+#define TRACE_BINARY 2
+#define TRACE_FORMAT TRACE_TEXT
+
+// file the dispatch trace is written to, (void*)0 for standard output
+#define TRACE_FILE_NAME ((void*)0)
+
 #define NEW 1
 #define READY 2
 #define RUNNING 3
@@ -36,17 +139,100 @@ struct process
 	int iProcessId;
 	struct timeval oTimeCreated;
 	int iBurstTime;
+	// burst time the process was created with, iBurstTime is the remaining burst time
+	int iInitialBurstTime;
 	struct process * oNext;
+	// previous process in a run_queue, so that a process can be unlinked in O(1)
+	struct process * oPrev;
 	int iState;
 	int iEventType;
+	// priority the process was given by a workload trace, 0 otherwise
+	int iPriority;
+	// probability (percent) that the process blocks when it runs, BLOCKING_PROBABILITY unless a workload trace says otherwise
+	int iBlockingProbability;
+	// position of the process in a process_heap or slot in a process_table, -1 when it is not queued in one
+	int iHeapIndex;
+	// nice value of the process, from -20 (largest share of the CPU) to 19. taken from the priority of a workload trace, 0 otherwise
+	int iNice;
+	// time the process has run, in micro seconds, scaled by the weight of its nice value, see 'process_tree.h'
+	long long int iVirtualRuntime;
+	// absolute deadline of a real-time job, and its deadline relative to its release (oTimeCreated) in milli seconds. 0 when the process has no deadline
+	struct timeval oDeadline;
+	int iRelativeDeadline;
+	// time, in milli seconds, between two releases of a periodic task. 0 when the process is not periodic
+	int iPeriod;
+	// consumer (CPU) the process ran on last, -1 before it first ran
+	int iCpu;
+	// time, on the getTimeInNanoSeconds clock, at which the process was created or last put back in a ready queue
+	long long int iReadySince;
+	// process id of the child that runs for the process in FORKED_PROCESSES mode, 0 until it first runs and once it has finished
+	int iChild;
+	// links of the process in a process_tree
+	struct process * oTreeLeft;
+	struct process * oTreeRight;
+	struct process * oTreeParent;
+	int iTreeColour;
+};
+
+/*
+ * Sizes of a scheduler run. Only change them while no scheduler is running.
+ */
+struct scheduler_parameters
+{
+	int iTimeSlice;
+	int iNumberOfProcesses;
+	int iBufferSize;
+	int iNumberOfConsumers;
+	int iSubmitBatchSize;
+	int iForkedProcesses;
+	int iBurstMode;
+};
+
+extern struct scheduler_parameters oSchedulerParameters;
+
+/*
+ * Intrusive doubly linked FIFO of processes, linked through oNext and oPrev. Pushing at the back, popping at the front and unlinking any process are O(1), and so is the length.
+ * A process can only be in one run_queue at a time. Like the other queues, the run_queue is not synchronised.
+ */
+struct run_queue
+{
+	struct process * oHead;
+	struct process * oTail;
+	size_t iLength;
 };
 
 struct process * generateProcess();
+size_t generateProcesses(struct process ** aBatch, size_t iWanted);
+void waitForNextArrival();
 long int getDifferenceInMilliSeconds(struct timeval start, struct timeval end);
+long long int getTimeInNanoSeconds();
+const char * getClockSource();
+const char * getBurstModeName(int iMode);
+int parseBurstMode(const char * sName);
 void simulateSJFProcess(struct process * oTemp, struct timeval * oStartTime, struct timeval * oEndTime);
 void simulateRoundRobinProcess(struct process * oTemp, struct timeval * oStartTime, struct timeval * oEndTime);
+void simulateRoundRobinProcessWithTimeSlice(struct process * oTemp, int iTimeSlice, struct timeval * oStartTime, struct timeval * oEndTime);
 void simulateBlockingRoundRobinProcess(struct process * oTemp, struct timeval * oStartTime, struct timeval * oEndTime);
+void simulateBlockingRoundRobinProcessWithTimeSlice(struct process * oTemp, int iTimeSlice, struct timeval * oStartTime, struct timeval * oEndTime);
 void runProcess(int iBurstTime, struct timeval * oStartTime, struct timeval * oEndTime);
 int generateBurstTime(struct process * oTemp);
+int generateBurstTimeWithTimeSlice(struct process * oTemp, int iTimeSlice);
 int generateEventType();
+int allocateProcessId();
+void resetProcessIds();
+int generateRandomNumber(int iBound);
+void setRandomStream(int iStream);
+void setRandomSeed(unsigned long long int iSeed);
+void setSimulationMode(int iMode);
+int getSimulationMode();
+void getCurrentTime(struct timeval * oTime);
+void setVirtualTime(struct timeval oTime);
+void addMilliSeconds(struct timeval * oTime, long int iMilliSeconds);
+void run_queue_init(struct run_queue * oQueue);
+size_t run_queue_length(const struct run_queue * oQueue);
+void run_queue_push_back(struct run_queue * oQueue, struct process * oTemp);
+struct process * run_queue_pop_front(struct run_queue * oQueue);
+void run_queue_unlink(struct run_queue * oQueue, struct process * oTemp);
+void run_queue_splice(struct run_queue * oDestination, struct run_queue * oSource);
 
+#endif
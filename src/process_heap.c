@@ -0,0 +1,181 @@
+#include <stdlib.h>
+#include <assert.h>
+#include "process_heap.h"
+
+/*
+ * Returns true if process a has to be run before process b, i.e. it has the shorter burst time (or the earlier deadline) or, on a tie, was created first.
+ */
+static int process_heap_before(const struct process_heap * oHeap, const struct process * a, const struct process * b)
+{
+	if(oHeap->iOrder == HEAP_ORDER_DEADLINE)
+	{
+		if(a->oDeadline.tv_sec != b->oDeadline.tv_sec)
+			return a->oDeadline.tv_sec < b->oDeadline.tv_sec;
+		if(a->oDeadline.tv_usec != b->oDeadline.tv_usec)
+			return a->oDeadline.tv_usec < b->oDeadline.tv_usec;
+	}
+	else if(a->iBurstTime != b->iBurstTime)
+		return a->iBurstTime < b->iBurstTime;
+	return a->iProcessId < b->iProcessId;
+}
+
+/*
+ * Places the process at the given position in the heap and keeps its back reference up to date.
+ */
+static void process_heap_place(struct process_heap * oHeap, size_t iIndex, struct process * oTemp)
+{
+	oHeap->aNodes[iIndex] = oTemp;
+	oTemp->iHeapIndex = (int) iIndex;
+}
+
+static void process_heap_sift_up(struct process_heap * oHeap, size_t iIndex)
+{
+	struct process * oTemp = oHeap->aNodes[iIndex];
+	while(iIndex > 0)
+	{
+		size_t iParent = (iIndex - 1) / 2;
+		if(!process_heap_before(oHeap, oTemp, oHeap->aNodes[iParent]))
+			break;
+		process_heap_place(oHeap, iIndex, oHeap->aNodes[iParent]);
+		iIndex = iParent;
+	}
+	process_heap_place(oHeap, iIndex, oTemp);
+}
+
+static void process_heap_sift_down(struct process_heap * oHeap, size_t iIndex)
+{
+	struct process * oTemp = oHeap->aNodes[iIndex];
+	for(;;)
+	{
+		size_t iChild = 2 * iIndex + 1;
+		if(iChild >= oHeap->iSize)
+			break;
+		if(iChild + 1 < oHeap->iSize && process_heap_before(oHeap, oHeap->aNodes[iChild + 1], oHeap->aNodes[iChild]))
+			iChild++;
+		if(!process_heap_before(oHeap, oHeap->aNodes[iChild], oTemp))
+			break;
+		process_heap_place(oHeap, iIndex, oHeap->aNodes[iChild]);
+		iIndex = iChild;
+	}
+	process_heap_place(oHeap, iIndex, oTemp);
+}
+
+/*
+ * Initialises an empty heap on the burst time. The capacity is only a hint, the heap grows when required.
+ */
+void process_heap_init(struct process_heap * oHeap, size_t iInitialCapacity)
+{
+	process_heap_init_ordered(oHeap, iInitialCapacity, HEAP_ORDER_BURST_TIME);
+}
+
+/*
+ * Initialises an empty heap on the burst time (HEAP_ORDER_BURST_TIME) or on the absolute deadline (HEAP_ORDER_DEADLINE).
+ */
+void process_heap_init_ordered(struct process_heap * oHeap, size_t iInitialCapacity, int iOrder)
+{
+	oHeap->iOrder = iOrder;
+	if(iInitialCapacity == 0)
+		iInitialCapacity = 1;
+	oHeap->aNodes = (struct process **) malloc(iInitialCapacity * sizeof(struct process *));
+	assert(oHeap->aNodes != NULL);
+	oHeap->iSize = 0;
+	oHeap->iCapacity = iInitialCapacity;
+}
+
+/*
+ * Releases the memory used by the heap itself. Processes that are still queued are not freed.
+ */
+void process_heap_destroy(struct process_heap * oHeap)
+{
+	free(oHeap->aNodes);
+	oHeap->aNodes = NULL;
+	oHeap->iSize = 0;
+	oHeap->iCapacity = 0;
+}
+
+size_t process_heap_size(const struct process_heap * oHeap)
+{
+	return oHeap->iSize;
+}
+
+/*
+ * Inserts the process in O(log n).
+ */
+void process_heap_push(struct process_heap * oHeap, struct process * oTemp)
+{
+	if(oHeap->iSize == oHeap->iCapacity)
+	{
+		oHeap->iCapacity *= 2;
+		oHeap->aNodes = (struct process **) realloc(oHeap->aNodes, oHeap->iCapacity * sizeof(struct process *));
+		assert(oHeap->aNodes != NULL);
+	}
+	oTemp->oNext = NULL;
+	process_heap_place(oHeap, oHeap->iSize++, oTemp);
+	process_heap_sift_up(oHeap, oTemp->iHeapIndex);
+}
+
+/*
+ * Inserts a batch of processes. A batch at least as large as the heap is appended as it is and the whole heap is rebuilt bottom up in O(n),
+ * a smaller one is pushed one process at a time in O(k log n).
+ */
+void process_heap_push_batch(struct process_heap * oHeap, struct process ** aProcesses, size_t iCount)
+{
+	size_t i;
+	if(iCount < oHeap->iSize)
+	{
+		for(i = 0; i < iCount; i++)
+			process_heap_push(oHeap, aProcesses[i]);
+		return;
+	}
+	if(oHeap->iSize + iCount > oHeap->iCapacity)
+	{
+		while(oHeap->iSize + iCount > oHeap->iCapacity)
+			oHeap->iCapacity *= 2;
+		oHeap->aNodes = (struct process **) realloc(oHeap->aNodes, oHeap->iCapacity * sizeof(struct process *));
+		assert(oHeap->aNodes != NULL);
+	}
+	for(i = 0; i < iCount; i++)
+	{
+		aProcesses[i]->oNext = NULL;
+		process_heap_place(oHeap, oHeap->iSize++, aProcesses[i]);
+	}
+	for(i = oHeap->iSize / 2; i-- > 0;)
+		process_heap_sift_down(oHeap, i);
+}
+
+/*
+ * Returns the first process (the shortest burst time or the earliest deadline) without removing it, or NULL if the heap is empty.
+ */
+struct process * process_heap_peek(const struct process_heap * oHeap)
+{
+	return oHeap->iSize == 0 ? NULL : oHeap->aNodes[0];
+}
+
+/*
+ * Removes and returns the first process in O(log n), or NULL if the heap is empty.
+ */
+struct process * process_heap_pop(struct process_heap * oHeap)
+{
+	struct process * oTemp = process_heap_peek(oHeap);
+	if(oTemp != NULL)
+		process_heap_remove(oHeap, oTemp);
+	return oTemp;
+}
+
+/*
+ * Removes an arbitrary process from the heap in O(log n). The process must currently be queued in this heap.
+ */
+void process_heap_remove(struct process_heap * oHeap, struct process * oTemp)
+{
+	size_t iIndex = (size_t) oTemp->iHeapIndex;
+	assert(oTemp->iHeapIndex >= 0 && iIndex < oHeap->iSize && oHeap->aNodes[iIndex] == oTemp);
+	oTemp->iHeapIndex = -1;
+	struct process * oLast = oHeap->aNodes[--oHeap->iSize];
+	if(oLast == oTemp)
+		return;
+	process_heap_place(oHeap, iIndex, oLast);
+	if(iIndex > 0 && process_heap_before(oHeap, oLast, oHeap->aNodes[(iIndex - 1) / 2]))
+		process_heap_sift_up(oHeap, iIndex);
+	else
+		process_heap_sift_down(oHeap, iIndex);
+}
@@ -0,0 +1,35 @@
+#ifndef PROCESS_HEAP_H
+#define PROCESS_HEAP_H
+
+#include <stddef.h>
+#include "posix_utility.h"
+
+// keys of the heap
+#define HEAP_ORDER_BURST_TIME 0
+#define HEAP_ORDER_DEADLINE 1
+
+/*
+ * Indexed binary min-heap of processes, keyed on the (remaining) burst time. Used as the ready queue of the SJF schedulers, and keyed on the absolute deadline as the ready queue of the EDF scheduler.
+ * Processes with equal keys come out in the order of their process id, i.e. first come first served.
+ * Every queued process knows its own position in the heap (iHeapIndex), so it can be removed in O(log n) without a search.
+ * The heap does not synchronise anything itself, the caller is responsible for locking when it is shared between threads.
+ */
+struct process_heap
+{
+	struct process ** aNodes;
+	size_t iSize;
+	size_t iCapacity;
+	int iOrder;
+};
+
+void process_heap_init(struct process_heap * oHeap, size_t iInitialCapacity);
+void process_heap_init_ordered(struct process_heap * oHeap, size_t iInitialCapacity, int iOrder);
+void process_heap_destroy(struct process_heap * oHeap);
+size_t process_heap_size(const struct process_heap * oHeap);
+void process_heap_push(struct process_heap * oHeap, struct process * oTemp);
+void process_heap_push_batch(struct process_heap * oHeap, struct process ** aProcesses, size_t iCount);
+struct process * process_heap_peek(const struct process_heap * oHeap);
+struct process * process_heap_pop(struct process_heap * oHeap);
+void process_heap_remove(struct process_heap * oHeap, struct process * oTemp);
+
+#endif
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "process_pool.h"
+
+// free records of the calling thread, linked through oNext
+static __thread struct process * oLocalFree = NULL;
+static __thread int iLocalFree = 0;
+static __thread int iRegistered = 0;
+
+// free records shared between the threads
+static pthread_mutex_t oDepotLock = PTHREAD_MUTEX_INITIALIZER;
+static struct process * oDepotFree = NULL;
+static long int iDepotFree = 0;
+
+// gives the free list of a thread back to the depot when the thread exits
+static pthread_once_t oKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t oThreadExitKey;
+
+static atomic_long iSlabs = 0;
+static atomic_long iAllocations = 0;
+static atomic_long iInUse = 0;
+static atomic_long iHighWaterMark = 0;
+
+static void process_pool_thread_exit(void * oUnused)
+{
+	if(oLocalFree == NULL)
+		return;
+	struct process * oLast = oLocalFree;
+	while(oLast->oNext != NULL)
+		oLast = oLast->oNext;
+	pthread_mutex_lock(&oDepotLock);
+	oLast->oNext = oDepotFree;
+	oDepotFree = oLocalFree;
+	iDepotFree += iLocalFree;
+	pthread_mutex_unlock(&oDepotLock);
+	oLocalFree = NULL;
+	iLocalFree = 0;
+}
+
+static void process_pool_create_key()
+{
+	pthread_key_create(&oThreadExitKey, process_pool_thread_exit);
+}
+
+/*
+ * Makes sure the free list of the calling thread is handed back when it exits. The main thread never runs key destructors, which does not matter as the program is ending.
+ */
+static void process_pool_register_thread()
+{
+	pthread_once(&oKeyOnce, process_pool_create_key);
+	pthread_setspecific(oThreadExitKey, (void *) 1);
+	iRegistered = 1;
+}
+
+/*
+ * Refills the free list of the calling thread with up to half a cache worth of records from the depot, or with a new slab if the depot is empty.
+ */
+static void process_pool_refill()
+{
+	int i;
+	if(!iRegistered)
+		process_pool_register_thread();
+	pthread_mutex_lock(&oDepotLock);
+	if(oDepotFree == NULL)
+	{
+		pthread_mutex_unlock(&oDepotLock);
+		struct process * aSlab = (struct process *) malloc(PROCESS_POOL_SLAB_SIZE * sizeof(struct process));
+		assert(aSlab != NULL);
+		for(i = PROCESS_POOL_SLAB_SIZE - 1; i >= 0; i--)
+		{
+			aSlab[i].oNext = oLocalFree;
+			oLocalFree = &aSlab[i];
+		}
+		iLocalFree += PROCESS_POOL_SLAB_SIZE;
+		atomic_fetch_add_explicit(&iSlabs, 1, memory_order_relaxed);
+		return;
+	}
+	while(oDepotFree != NULL && iLocalFree < PROCESS_POOL_CACHE_SIZE / 2)
+	{
+		struct process * oTemp = oDepotFree;
+		oDepotFree = oTemp->oNext;
+		iDepotFree--;
+		oTemp->oNext = oLocalFree;
+		oLocalFree = oTemp;
+		iLocalFree++;
+	}
+	pthread_mutex_unlock(&oDepotLock);
+}
+
+/*
+ * Hands half of the free list of the calling thread back to the depot, so that the threads that allocate can reuse them.
+ */
+static void process_pool_flush()
+{
+	struct process * oFirst = oLocalFree;
+	struct process * oLast = oLocalFree;
+	int iCount = 1;
+	while(iCount < PROCESS_POOL_CACHE_SIZE / 2)
+	{
+		oLast = oLast->oNext;
+		iCount++;
+	}
+	oLocalFree = oLast->oNext;
+	iLocalFree -= iCount;
+	pthread_mutex_lock(&oDepotLock);
+	oLast->oNext = oDepotFree;
+	oDepotFree = oFirst;
+	iDepotFree += iCount;
+	pthread_mutex_unlock(&oDepotLock);
+}
+
+/*
+ * Returns an uninitialised process record. Use this instead of malloc for every struct process.
+ */
+struct process * process_alloc()
+{
+	if(oLocalFree == NULL)
+		process_pool_refill();
+	struct process * oTemp = oLocalFree;
+	oLocalFree = oTemp->oNext;
+	iLocalFree--;
+
+	atomic_fetch_add_explicit(&iAllocations, 1, memory_order_relaxed);
+	long int iCurrent = atomic_fetch_add_explicit(&iInUse, 1, memory_order_relaxed) + 1;
+	long int iHighest = atomic_load_explicit(&iHighWaterMark, memory_order_relaxed);
+	while(iCurrent > iHighest && !atomic_compare_exchange_weak_explicit(&iHighWaterMark, &iHighest, iCurrent, memory_order_relaxed, memory_order_relaxed));
+	return oTemp;
+}
+
+/*
+ * Recycles the record of a process that has finished. Use this instead of free.
+ */
+void process_release(struct process * oTemp)
+{
+	assert(oTemp->iState == FINISHED);
+	atomic_fetch_sub_explicit(&iInUse, 1, memory_order_relaxed);
+	oTemp->oNext = oLocalFree;
+	oLocalFree = oTemp;
+	iLocalFree++;
+	if(!iRegistered)
+		process_pool_register_thread();
+	if(iLocalFree > PROCESS_POOL_CACHE_SIZE)
+		process_pool_flush();
+}
+
+void process_pool_get_stats(struct process_pool_stats * oStats)
+{
+	oStats->iSlabs = atomic_load(&iSlabs);
+	oStats->iAllocations = atomic_load(&iAllocations);
+	oStats->iInUse = atomic_load(&iInUse);
+	oStats->iHighWaterMark = atomic_load(&iHighWaterMark);
+}
+
+void process_pool_print_stats()
+{
+	struct process_pool_stats oStats;
+	process_pool_get_stats(&oStats);
+	printf("Process pool: %ld allocations, %ld slabs of %d records, high water mark = %ld records, %ld still in use\n", oStats.iAllocations, oStats.iSlabs, PROCESS_POOL_SLAB_SIZE, oStats.iHighWaterMark, oStats.iInUse);
+}
@@ -0,0 +1,31 @@
+#ifndef PROCESS_POOL_H
+#define PROCESS_POOL_H
+
+#include "posix_utility.h"
+
+// number of process records allocated at once when the pool runs dry
+#define PROCESS_POOL_SLAB_SIZE 4096
+
+// maximum number of free records a thread keeps for itself, half of them go back to the shared depot when it is exceeded
+#define PROCESS_POOL_CACHE_SIZE 256
+
+/*
+ * Pool of process records. Records come from large slabs which are never given back to the allocator while the program runs.
+ * Every thread keeps a free list of its own, so allocating and releasing a record normally takes no lock at all.
+ * Free lists are balanced through a shared depot in batches, since in the bounded schedulers the creator allocates all the records and the consumers release them.
+ */
+struct process_pool_stats
+{
+	long int iSlabs;
+	long int iAllocations;
+	long int iInUse;
+	// largest number of records that were in use at the same time
+	long int iHighWaterMark;
+};
+
+struct process * process_alloc();
+void process_release(struct process * oTemp);
+void process_pool_get_stats(struct process_pool_stats * oStats);
+void process_pool_print_stats();
+
+#endif
@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <pthread.h>
+#include "process_table.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PROCESS_TABLE_X86 1
+#endif
+
+// the arrays are aligned for the widest vector loads
+#define PROCESS_TABLE_ALIGNMENT 32
+
+/*
+ * Returns the slot of the shortest job among the slots holding iShortest, the one with the lowest process id on a tie.
+ */
+static int process_table_lowest_id(const int32_t * aBurstTimes, const int32_t * aProcessIds, int iFrom, int iSize, int iShortest, int iBest)
+{
+	int i;
+	for(i = iFrom; i < iSize; i++)
+		if(aBurstTimes[i] == iShortest && (iBest < 0 || aProcessIds[i] < aProcessIds[iBest]))
+			iBest = i;
+	return iBest;
+}
+
+static int process_table_find_scalar(const int32_t * aBurstTimes, const int32_t * aProcessIds, int iSize)
+{
+	int i;
+	int iShortest = INT_MAX;
+	for(i = 0; i < iSize; i++)
+		if(aBurstTimes[i] < iShortest)
+			iShortest = aBurstTimes[i];
+	return process_table_lowest_id(aBurstTimes, aProcessIds, 0, iSize, iShortest, -1);
+}
+
+#ifdef PROCESS_TABLE_X86
+/*
+ * Both vector versions make two passes: the first finds the shortest burst time with packed minimums, the second compares the burst times with it
+ * and only looks at the process ids of the lanes that match, which normally is a single one.
+ */
+__attribute__((target("sse4.1")))
+static int process_table_find_sse(const int32_t * aBurstTimes, const int32_t * aProcessIds, int iSize)
+{
+	int i;
+	int iBest = -1;
+	__m128i vShortest = _mm_set1_epi32(INT_MAX);
+	for(i = 0; i + 4 <= iSize; i += 4)
+		vShortest = _mm_min_epi32(vShortest, _mm_load_si128((const __m128i *) &aBurstTimes[i]));
+	vShortest = _mm_min_epi32(vShortest, _mm_shuffle_epi32(vShortest, _MM_SHUFFLE(1, 0, 3, 2)));
+	vShortest = _mm_min_epi32(vShortest, _mm_shuffle_epi32(vShortest, _MM_SHUFFLE(2, 3, 0, 1)));
+	int iShortest = _mm_cvtsi128_si32(vShortest);
+	for(; i < iSize; i++)
+		if(aBurstTimes[i] < iShortest)
+			iShortest = aBurstTimes[i];
+
+	vShortest = _mm_set1_epi32(iShortest);
+	for(i = 0; i + 4 <= iSize; i += 4)
+	{
+		int iMask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_load_si128((const __m128i *) &aBurstTimes[i]), vShortest)));
+		for(; iMask != 0; iMask &= iMask - 1)
+		{
+			int iSlot = i + __builtin_ctz(iMask);
+			if(iBest < 0 || aProcessIds[iSlot] < aProcessIds[iBest])
+				iBest = iSlot;
+		}
+	}
+	return process_table_lowest_id(aBurstTimes, aProcessIds, i, iSize, iShortest, iBest);
+}
+
+__attribute__((target("avx2")))
+static int process_table_find_avx2(const int32_t * aBurstTimes, const int32_t * aProcessIds, int iSize)
+{
+	int i;
+	int iBest = -1;
+	__m256i vShortest = _mm256_set1_epi32(INT_MAX);
+	for(i = 0; i + 8 <= iSize; i += 8)
+		vShortest = _mm256_min_epi32(vShortest, _mm256_load_si256((const __m256i *) &aBurstTimes[i]));
+	__m128i vHalf = _mm_min_epi32(_mm256_castsi256_si128(vShortest), _mm256_extracti128_si256(vShortest, 1));
+	vHalf = _mm_min_epi32(vHalf, _mm_shuffle_epi32(vHalf, _MM_SHUFFLE(1, 0, 3, 2)));
+	vHalf = _mm_min_epi32(vHalf, _mm_shuffle_epi32(vHalf, _MM_SHUFFLE(2, 3, 0, 1)));
+	int iShortest = _mm_cvtsi128_si32(vHalf);
+	for(; i < iSize; i++)
+		if(aBurstTimes[i] < iShortest)
+			iShortest = aBurstTimes[i];
+
+	vShortest = _mm256_set1_epi32(iShortest);
+	for(i = 0; i + 8 <= iSize; i += 8)
+	{
+		int iMask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_load_si256((const __m256i *) &aBurstTimes[i]), vShortest)));
+		for(; iMask != 0; iMask &= iMask - 1)
+		{
+			int iSlot = i + __builtin_ctz(iMask);
+			if(iBest < 0 || aProcessIds[iSlot] < aProcessIds[iBest])
+				iBest = iSlot;
+		}
+	}
+	return process_table_lowest_id(aBurstTimes, aProcessIds, i, iSize, iShortest, iBest);
+}
+#endif
+
+// the scan used on this CPU, chosen once
+static pthread_once_t oSelectOnce = PTHREAD_ONCE_INIT;
+static int (*pFindShortest)(const int32_t *, const int32_t *, int) = process_table_find_scalar;
+static const char * sImplementation = "scalar";
+
+static void process_table_select()
+{
+#ifdef PROCESS_TABLE_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+	{
+		pFindShortest = process_table_find_avx2;
+		sImplementation = "avx2";
+	}
+	else if(__builtin_cpu_supports("sse4.1"))
+	{
+		pFindShortest = process_table_find_sse;
+		sImplementation = "sse4.1";
+	}
+#endif
+}
+
+static void * process_table_allocate(size_t iBytes)
+{
+	// aligned_alloc wants a multiple of the alignment
+	iBytes = (iBytes + PROCESS_TABLE_ALIGNMENT - 1) / PROCESS_TABLE_ALIGNMENT * PROCESS_TABLE_ALIGNMENT;
+	void * pMemory = aligned_alloc(PROCESS_TABLE_ALIGNMENT, iBytes);
+	assert(pMemory != NULL);
+	return pMemory;
+}
+
+/*
+ * Moves the arrays to new ones of iCapacity slots.
+ */
+static void process_table_resize(struct process_table * oTable, int iCapacity)
+{
+	int32_t * aBurstTimes = (int32_t *) process_table_allocate(iCapacity * sizeof(int32_t));
+	int32_t * aProcessIds = (int32_t *) process_table_allocate(iCapacity * sizeof(int32_t));
+	struct process ** aProcesses = (struct process **) process_table_allocate(iCapacity * sizeof(struct process *));
+	if(oTable->iSize > 0)
+	{
+		memcpy(aBurstTimes, oTable->aBurstTimes, oTable->iSize * sizeof(int32_t));
+		memcpy(aProcessIds, oTable->aProcessIds, oTable->iSize * sizeof(int32_t));
+		memcpy(aProcesses, oTable->aProcesses, oTable->iSize * sizeof(struct process *));
+	}
+	free(oTable->aBurstTimes);
+	free(oTable->aProcessIds);
+	free(oTable->aProcesses);
+	oTable->aBurstTimes = aBurstTimes;
+	oTable->aProcessIds = aProcessIds;
+	oTable->aProcesses = aProcesses;
+	oTable->iCapacity = iCapacity;
+}
+
+/*
+ * Initialises an empty table. The capacity is only a hint, the table grows when required.
+ */
+void process_table_init(struct process_table * oTable, int iInitialCapacity)
+{
+	pthread_once(&oSelectOnce, process_table_select);
+	memset(oTable, 0, sizeof(struct process_table));
+	process_table_resize(oTable, iInitialCapacity > 0 ? iInitialCapacity : 16);
+}
+
+void process_table_destroy(struct process_table * oTable)
+{
+	free(oTable->aBurstTimes);
+	free(oTable->aProcessIds);
+	free(oTable->aProcesses);
+	memset(oTable, 0, sizeof(struct process_table));
+}
+
+int process_table_size(const struct process_table * oTable)
+{
+	return oTable->iSize;
+}
+
+/*
+ * Adds the process and returns its slot. The slot is also kept in iHeapIndex, as slots change when other processes are removed.
+ */
+int process_table_insert(struct process_table * oTable, struct process * oTemp)
+{
+	if(oTable->iSize == oTable->iCapacity)
+		process_table_resize(oTable, oTable->iCapacity * 2);
+	int iSlot = oTable->iSize++;
+	oTable->aBurstTimes[iSlot] = oTemp->iBurstTime;
+	oTable->aProcessIds[iSlot] = oTemp->iProcessId;
+	oTable->aProcesses[iSlot] = oTemp;
+	oTemp->iHeapIndex = iSlot;
+	return iSlot;
+}
+
+/*
+ * Returns the slot of the shortest job, or -1 if the table is empty.
+ */
+int process_table_find_shortest(const struct process_table * oTable)
+{
+	if(oTable->iSize == 0)
+		return -1;
+	return pFindShortest(oTable->aBurstTimes, oTable->aProcessIds, oTable->iSize);
+}
+
+/*
+ * Takes the process out of the slot. The last process moves into the slot, so that the used slots stay dense.
+ */
+struct process * process_table_remove(struct process_table * oTable, int iSlot)
+{
+	assert(iSlot >= 0 && iSlot < oTable->iSize);
+	struct process * oTemp = oTable->aProcesses[iSlot];
+	int iLast = --oTable->iSize;
+	if(iSlot != iLast)
+	{
+		oTable->aBurstTimes[iSlot] = oTable->aBurstTimes[iLast];
+		oTable->aProcessIds[iSlot] = oTable->aProcessIds[iLast];
+		oTable->aProcesses[iSlot] = oTable->aProcesses[iLast];
+		oTable->aProcesses[iSlot]->iHeapIndex = iSlot;
+	}
+	oTemp->iHeapIndex = -1;
+	return oTemp;
+}
+
+/*
+ * Takes the shortest job out of the table. Returns NULL if it is empty.
+ */
+struct process * process_table_pop_shortest(struct process_table * oTable)
+{
+	int iSlot = process_table_find_shortest(oTable);
+	if(iSlot < 0)
+		return NULL;
+	return process_table_remove(oTable, iSlot);
+}
+
+/*
+ * Name of the scan that is used on this CPU: "avx2", "sse4.1" or "scalar".
+ */
+const char * process_table_implementation()
+{
+	pthread_once(&oSelectOnce, process_table_select);
+	return sImplementation;
+}
@@ -0,0 +1,33 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <stdint.h>
+#include "posix_utility.h"
+
+/*
+ * Ready set of processes stored as a structure of arrays: the burst times and process ids of the processes sit in separate contiguous arrays, indexed by slot.
+ * The used slots are always 0 .. iSize - 1 (removing a process moves the last one into its slot), so finding the shortest job is a linear scan over a dense int array,
+ * which is vectorised with AVX2 or SSE4.1 when the CPU has them. Processes with equal burst times are picked in the order of their process id, as in process_heap.
+ * Meant for batch SJF, where large ready sets are rescanned for every selection. Like the other queues, the table is not synchronised.
+ * There is no column for the states of the processes: batch SJF runs every process it takes out of the table to completion and never puts one back,
+ * so every process in the table is ready and the scan would have nothing to skip. The state of a process is only kept in its struct process.
+ */
+struct process_table
+{
+	int32_t * aBurstTimes;
+	int32_t * aProcessIds;
+	struct process ** aProcesses;
+	int iSize;
+	int iCapacity;
+};
+
+void process_table_init(struct process_table * oTable, int iInitialCapacity);
+void process_table_destroy(struct process_table * oTable);
+int process_table_size(const struct process_table * oTable);
+int process_table_insert(struct process_table * oTable, struct process * oTemp);
+int process_table_find_shortest(const struct process_table * oTable);
+struct process * process_table_remove(struct process_table * oTable, int iSlot);
+struct process * process_table_pop_shortest(struct process_table * oTable);
+const char * process_table_implementation();
+
+#endif
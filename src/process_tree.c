@@ -0,0 +1,333 @@
+#include <stdlib.h>
+#include <assert.h>
+#include "process_tree.h"
+
+#define TREE_RED 0
+#define TREE_BLACK 1
+
+// weights of the nice values -20 .. 19, the same as the scheduler of Linux uses
+static const int aNiceToWeight[40] =
+{
+	88761, 71755, 56483, 46273, 36291,
+	29154, 23254, 18705, 14949, 11916,
+	9548, 7620, 6100, 4904, 3906,
+	3121, 2501, 1991, 1586, 1277,
+	1024, 820, 655, 526, 423,
+	335, 272, 215, 172, 137,
+	110, 87, 70, 56, 45,
+	36, 29, 23, 18, 15,
+};
+
+int process_tree_weight(int iNice)
+{
+	assert(iNice >= -20 && iNice <= 19);
+	return aNiceToWeight[iNice + 20];
+}
+
+static int process_tree_is_red(const struct process * oTemp)
+{
+	return oTemp != NULL && oTemp->iTreeColour == TREE_RED;
+}
+
+// order of the tree: virtual runtime, then process id
+static int process_tree_less(const struct process * oFirst, const struct process * oSecond)
+{
+	if(oFirst->iVirtualRuntime != oSecond->iVirtualRuntime)
+		return oFirst->iVirtualRuntime < oSecond->iVirtualRuntime;
+	return oFirst->iProcessId < oSecond->iProcessId;
+}
+
+static struct process * process_tree_minimum(struct process * oTemp)
+{
+	while(oTemp->oTreeLeft != NULL)
+		oTemp = oTemp->oTreeLeft;
+	return oTemp;
+}
+
+// puts oNew where oOld hangs from its parent. oNew may be NULL
+static void process_tree_replace(struct process_tree * oTree, struct process * oOld, struct process * oNew)
+{
+	if(oOld->oTreeParent == NULL)
+		oTree->oRoot = oNew;
+	else if(oOld == oOld->oTreeParent->oTreeLeft)
+		oOld->oTreeParent->oTreeLeft = oNew;
+	else
+		oOld->oTreeParent->oTreeRight = oNew;
+	if(oNew != NULL)
+		oNew->oTreeParent = oOld->oTreeParent;
+}
+
+static void process_tree_rotate_left(struct process_tree * oTree, struct process * oTemp)
+{
+	struct process * oChild = oTemp->oTreeRight;
+	oTemp->oTreeRight = oChild->oTreeLeft;
+	if(oChild->oTreeLeft != NULL)
+		oChild->oTreeLeft->oTreeParent = oTemp;
+	process_tree_replace(oTree, oTemp, oChild);
+	oChild->oTreeLeft = oTemp;
+	oTemp->oTreeParent = oChild;
+}
+
+static void process_tree_rotate_right(struct process_tree * oTree, struct process * oTemp)
+{
+	struct process * oChild = oTemp->oTreeLeft;
+	oTemp->oTreeLeft = oChild->oTreeRight;
+	if(oChild->oTreeRight != NULL)
+		oChild->oTreeRight->oTreeParent = oTemp;
+	process_tree_replace(oTree, oTemp, oChild);
+	oChild->oTreeRight = oTemp;
+	oTemp->oTreeParent = oChild;
+}
+
+void process_tree_init(struct process_tree * oTree)
+{
+	oTree->oRoot = NULL;
+	oTree->oLeftmost = NULL;
+	oTree->iSize = 0;
+	oTree->iTotalWeight = 0;
+	oTree->iMinVirtualRuntime = 0;
+}
+
+size_t process_tree_size(const struct process_tree * oTree)
+{
+	return oTree->iSize;
+}
+
+/*
+ * Adds a runnable process. A process that is behind iMinVirtualRuntime (e.g. a new one) is moved up to it first.
+ */
+void process_tree_insert(struct process_tree * oTree, struct process * oTemp)
+{
+	struct process * oParent = NULL;
+	struct process * oCurrent = oTree->oRoot;
+	int iLeftmost = 1;
+	if(oTemp->iVirtualRuntime < oTree->iMinVirtualRuntime)
+		oTemp->iVirtualRuntime = oTree->iMinVirtualRuntime;
+	while(oCurrent != NULL)
+	{
+		oParent = oCurrent;
+		if(process_tree_less(oTemp, oCurrent))
+			oCurrent = oCurrent->oTreeLeft;
+		else
+		{
+			oCurrent = oCurrent->oTreeRight;
+			iLeftmost = 0;
+		}
+	}
+	oTemp->oTreeParent = oParent;
+	oTemp->oTreeLeft = NULL;
+	oTemp->oTreeRight = NULL;
+	oTemp->iTreeColour = TREE_RED;
+	if(oParent == NULL)
+		oTree->oRoot = oTemp;
+	else if(process_tree_less(oTemp, oParent))
+		oParent->oTreeLeft = oTemp;
+	else
+		oParent->oTreeRight = oTemp;
+	if(iLeftmost)
+		oTree->oLeftmost = oTemp;
+	oTree->iSize++;
+	oTree->iTotalWeight += process_tree_weight(oTemp->iNice);
+
+	// a red process may not have a red parent: recolour upwards, and rotate once the uncle is black
+	while(process_tree_is_red(oTemp->oTreeParent))
+	{
+		oParent = oTemp->oTreeParent;
+		struct process * oGrandParent = oParent->oTreeParent;
+		if(oParent == oGrandParent->oTreeLeft)
+		{
+			struct process * oUncle = oGrandParent->oTreeRight;
+			if(process_tree_is_red(oUncle))
+			{
+				oParent->iTreeColour = TREE_BLACK;
+				oUncle->iTreeColour = TREE_BLACK;
+				oGrandParent->iTreeColour = TREE_RED;
+				oTemp = oGrandParent;
+				continue;
+			}
+			if(oTemp == oParent->oTreeRight)
+			{
+				process_tree_rotate_left(oTree, oParent);
+				oTemp = oParent;
+				oParent = oTemp->oTreeParent;
+			}
+			oParent->iTreeColour = TREE_BLACK;
+			oGrandParent->iTreeColour = TREE_RED;
+			process_tree_rotate_right(oTree, oGrandParent);
+		}
+		else
+		{
+			struct process * oUncle = oGrandParent->oTreeLeft;
+			if(process_tree_is_red(oUncle))
+			{
+				oParent->iTreeColour = TREE_BLACK;
+				oUncle->iTreeColour = TREE_BLACK;
+				oGrandParent->iTreeColour = TREE_RED;
+				oTemp = oGrandParent;
+				continue;
+			}
+			if(oTemp == oParent->oTreeLeft)
+			{
+				process_tree_rotate_right(oTree, oParent);
+				oTemp = oParent;
+				oParent = oTemp->oTreeParent;
+			}
+			oParent->iTreeColour = TREE_BLACK;
+			oGrandParent->iTreeColour = TREE_RED;
+			process_tree_rotate_left(oTree, oGrandParent);
+		}
+	}
+	oTree->oRoot->iTreeColour = TREE_BLACK;
+}
+
+/*
+ * Removes a process from anywhere in the tree. The process must currently be in this tree.
+ */
+void process_tree_remove(struct process_tree * oTree, struct process * oTemp)
+{
+	struct process * oChild;
+	struct process * oParent;
+	int iRemovedColour = oTemp->iTreeColour;
+	if(oTemp == oTree->oLeftmost)
+		oTree->oLeftmost = oTemp->oTreeRight != NULL ? process_tree_minimum(oTemp->oTreeRight) : oTemp->oTreeParent;
+	if(oTemp->oTreeLeft == NULL || oTemp->oTreeRight == NULL)
+	{
+		oChild = oTemp->oTreeLeft != NULL ? oTemp->oTreeLeft : oTemp->oTreeRight;
+		oParent = oTemp->oTreeParent;
+		process_tree_replace(oTree, oTemp, oChild);
+	}
+	else
+	{
+		// two children: the successor takes the place (and the colour) of the process
+		struct process * oSuccessor = process_tree_minimum(oTemp->oTreeRight);
+		iRemovedColour = oSuccessor->iTreeColour;
+		oChild = oSuccessor->oTreeRight;
+		if(oSuccessor->oTreeParent == oTemp)
+			oParent = oSuccessor;
+		else
+		{
+			oParent = oSuccessor->oTreeParent;
+			process_tree_replace(oTree, oSuccessor, oChild);
+			oSuccessor->oTreeRight = oTemp->oTreeRight;
+			oSuccessor->oTreeRight->oTreeParent = oSuccessor;
+		}
+		process_tree_replace(oTree, oTemp, oSuccessor);
+		oSuccessor->oTreeLeft = oTemp->oTreeLeft;
+		oSuccessor->oTreeLeft->oTreeParent = oSuccessor;
+		oSuccessor->iTreeColour = oTemp->iTreeColour;
+	}
+	oTemp->oTreeLeft = NULL;
+	oTemp->oTreeRight = NULL;
+	oTemp->oTreeParent = NULL;
+	oTree->iSize--;
+	oTree->iTotalWeight -= process_tree_weight(oTemp->iNice);
+	if(iRemovedColour == TREE_RED)
+		return;
+
+	// a black process went missing on the path to oChild: push the extra black up, or borrow one from the sibling
+	while(oChild != oTree->oRoot && !process_tree_is_red(oChild))
+	{
+		if(oChild == oParent->oTreeLeft)
+		{
+			struct process * oSibling = oParent->oTreeRight;
+			if(process_tree_is_red(oSibling))
+			{
+				oSibling->iTreeColour = TREE_BLACK;
+				oParent->iTreeColour = TREE_RED;
+				process_tree_rotate_left(oTree, oParent);
+				oSibling = oParent->oTreeRight;
+			}
+			if(!process_tree_is_red(oSibling->oTreeLeft) && !process_tree_is_red(oSibling->oTreeRight))
+			{
+				oSibling->iTreeColour = TREE_RED;
+				oChild = oParent;
+				oParent = oChild->oTreeParent;
+				continue;
+			}
+			if(!process_tree_is_red(oSibling->oTreeRight))
+			{
+				oSibling->oTreeLeft->iTreeColour = TREE_BLACK;
+				oSibling->iTreeColour = TREE_RED;
+				process_tree_rotate_right(oTree, oSibling);
+				oSibling = oParent->oTreeRight;
+			}
+			oSibling->iTreeColour = oParent->iTreeColour;
+			oParent->iTreeColour = TREE_BLACK;
+			oSibling->oTreeRight->iTreeColour = TREE_BLACK;
+			process_tree_rotate_left(oTree, oParent);
+		}
+		else
+		{
+			struct process * oSibling = oParent->oTreeLeft;
+			if(process_tree_is_red(oSibling))
+			{
+				oSibling->iTreeColour = TREE_BLACK;
+				oParent->iTreeColour = TREE_RED;
+				process_tree_rotate_right(oTree, oParent);
+				oSibling = oParent->oTreeLeft;
+			}
+			if(!process_tree_is_red(oSibling->oTreeLeft) && !process_tree_is_red(oSibling->oTreeRight))
+			{
+				oSibling->iTreeColour = TREE_RED;
+				oChild = oParent;
+				oParent = oChild->oTreeParent;
+				continue;
+			}
+			if(!process_tree_is_red(oSibling->oTreeLeft))
+			{
+				oSibling->oTreeRight->iTreeColour = TREE_BLACK;
+				oSibling->iTreeColour = TREE_RED;
+				process_tree_rotate_left(oTree, oSibling);
+				oSibling = oParent->oTreeLeft;
+			}
+			oSibling->iTreeColour = oParent->iTreeColour;
+			oParent->iTreeColour = TREE_BLACK;
+			oSibling->oTreeLeft->iTreeColour = TREE_BLACK;
+			process_tree_rotate_right(oTree, oParent);
+		}
+		oChild = oTree->oRoot;
+	}
+	if(oChild != NULL)
+		oChild->iTreeColour = TREE_BLACK;
+}
+
+/*
+ * Returns the process with the smallest virtual runtime without taking it out, or NULL if the tree is empty. O(1).
+ */
+struct process * process_tree_first(const struct process_tree * oTree)
+{
+	return oTree->oLeftmost;
+}
+
+/*
+ * Takes the process with the smallest virtual runtime out of the tree. Returns NULL if it is empty.
+ */
+struct process * process_tree_pop_first(struct process_tree * oTree)
+{
+	struct process * oTemp = oTree->oLeftmost;
+	if(oTemp == NULL)
+		return NULL;
+	if(oTemp->iVirtualRuntime > oTree->iMinVirtualRuntime)
+		oTree->iMinVirtualRuntime = oTemp->iVirtualRuntime;
+	process_tree_remove(oTree, oTemp);
+	return oTemp;
+}
+
+/*
+ * Time slice, in milli seconds, of a process that has just been taken out of the tree: its share of CFS_TARGET_LATENCY among itself and the processes still in the tree,
+ * but at least CFS_MIN_GRANULARITY, so that a long tree does not make the processes switch all the time.
+ */
+int process_tree_time_slice(const struct process_tree * oTree, const struct process * oTemp)
+{
+	long long int iWeight = process_tree_weight(oTemp->iNice);
+	long long int iTimeSlice = CFS_TARGET_LATENCY * iWeight / (oTree->iTotalWeight + iWeight);
+	return iTimeSlice < CFS_MIN_GRANULARITY ? CFS_MIN_GRANULARITY : (int) iTimeSlice;
+}
+
+/*
+ * Adds the time the process has run to its virtual runtime, scaled by its weight.
+ */
+void process_tree_charge(struct process * oTemp, long long int iMicroSeconds)
+{
+	oTemp->iVirtualRuntime += iMicroSeconds * NICE_0_WEIGHT / process_tree_weight(oTemp->iNice);
+}
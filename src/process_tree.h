@@ -0,0 +1,37 @@
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+#include <stddef.h>
+#include "posix_utility.h"
+
+// weight of a process with nice value 0. every nice level up or down changes the weight by about 25%, as in Linux
+#define NICE_0_WEIGHT 1024
+
+/*
+ * Red-black tree of runnable processes keyed on the virtual runtime, the ready queue of the fair scheduler. Processes with equal virtual runtimes are ordered on their process id.
+ * The virtual runtime of a process grows by the time it runs, scaled by NICE_0_WEIGHT / weight, so that always running the leftmost process gives every process a share of the CPU in proportion to its weight.
+ * The tree is intrusive (linked through the oTree fields of the process), so inserting and removing never allocate and are O(log n). The leftmost process is cached, so finding it is O(1).
+ * Like the other queues, the tree is not synchronised.
+ */
+struct process_tree
+{
+	struct process * oRoot;
+	struct process * oLeftmost;
+	size_t iSize;
+	// sum of the weights of the processes in the tree
+	long long int iTotalWeight;
+	// never decreases: the virtual runtime of the leftmost process when it was last taken out. processes are inserted at least at this virtual runtime, so that a new process does not get the CPU to itself until it has caught up
+	long long int iMinVirtualRuntime;
+};
+
+void process_tree_init(struct process_tree * oTree);
+size_t process_tree_size(const struct process_tree * oTree);
+void process_tree_insert(struct process_tree * oTree, struct process * oTemp);
+void process_tree_remove(struct process_tree * oTree, struct process * oTemp);
+struct process * process_tree_first(const struct process_tree * oTree);
+struct process * process_tree_pop_first(struct process_tree * oTree);
+int process_tree_weight(int iNice);
+int process_tree_time_slice(const struct process_tree * oTree, const struct process * oTemp);
+void process_tree_charge(struct process * oTemp, long long int iMicroSeconds);
+
+#endif
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profiled_mutex.h"
+
+/*
+ * Statistics of the call sites of the mutexes that have been destroyed, added up per mutex name and call site.
+ */
+struct lock_total
+{
+	const char * sName;
+	struct lock_site oSite;
+	struct lock_total * oNext;
+};
+
+static pthread_mutex_t oTotalsLock = PTHREAD_MUTEX_INITIALIZER;
+static struct lock_total * oTotals = NULL;
+
+static struct lock_site * lock_site_new(const char * sFunction, int iLine)
+{
+	struct lock_site * oSite = (struct lock_site *) malloc(sizeof(struct lock_site));
+	assert(oSite != NULL);
+	oSite->sFunction = sFunction;
+	oSite->iLine = iLine;
+	oSite->iAcquisitions = 0;
+	oSite->iContended = 0;
+	latency_histogram_init(&(oSite->oWaitTime));
+	latency_histogram_init(&(oSite->oHoldTime));
+	oSite->oNext = NULL;
+	return oSite;
+}
+
+/*
+ * Returns the statistics of a call site of the mutex, adding them the first time the site locks it. Called with the mutex held.
+ */
+static struct lock_site * lock_site_of(struct profiled_mutex * oMutex, const char * sFunction, int iLine)
+{
+	struct lock_site * oSite;
+	for(oSite = oMutex->oSites; oSite != NULL; oSite = oSite->oNext)
+	{
+		if(oSite->iLine == iLine && oSite->sFunction == sFunction)
+			return oSite;
+	}
+	oSite = lock_site_new(sFunction, iLine);
+	oSite->oNext = oMutex->oSites;
+	oMutex->oSites = oSite;
+	return oSite;
+}
+
+/*
+ * Ends the current hold of the mutex. Called with the mutex held.
+ */
+static void profiled_mutex_end_hold(struct profiled_mutex * oMutex)
+{
+	latency_histogram_record(&(oMutex->oHolder->oHoldTime), getTimeInNanoSeconds() - oMutex->iLockedAt);
+}
+
+/*
+ * Initialises an unlocked mutex. Mutexes with the same name are reported together.
+ */
+void profiled_mutex_init(struct profiled_mutex * oMutex, const char * sName)
+{
+	pthread_mutex_init(&(oMutex->oMutex), NULL);
+	oMutex->sName = sName;
+	oMutex->oSites = NULL;
+	oMutex->oHolder = NULL;
+	oMutex->iLockedAt = 0;
+}
+
+/*
+ * Destroys the mutex, which must not be locked, and adds its statistics to the totals.
+ */
+void profiled_mutex_destroy(struct profiled_mutex * oMutex)
+{
+	pthread_mutex_destroy(&(oMutex->oMutex));
+	pthread_mutex_lock(&oTotalsLock);
+	while(oMutex->oSites != NULL)
+	{
+		struct lock_site * oSite = oMutex->oSites;
+		oMutex->oSites = oSite->oNext;
+		struct lock_total * oTotal;
+		for(oTotal = oTotals; oTotal != NULL; oTotal = oTotal->oNext)
+		{
+			if(oTotal->oSite.iLine == oSite->iLine && oTotal->oSite.sFunction == oSite->sFunction && strcmp(oTotal->sName, oMutex->sName) == 0)
+				break;
+		}
+		if(oTotal == NULL)
+		{
+			oTotal = (struct lock_total *) malloc(sizeof(struct lock_total));
+			assert(oTotal != NULL);
+			oTotal->sName = oMutex->sName;
+			oTotal->oSite = *oSite;
+			oTotal->oNext = oTotals;
+			oTotals = oTotal;
+		}
+		else
+		{
+			oTotal->oSite.iAcquisitions += oSite->iAcquisitions;
+			oTotal->oSite.iContended += oSite->iContended;
+			latency_histogram_merge(&(oTotal->oSite.oWaitTime), &(oSite->oWaitTime));
+			latency_histogram_merge(&(oTotal->oSite.oHoldTime), &(oSite->oHoldTime));
+		}
+		free(oSite);
+	}
+	pthread_mutex_unlock(&oTotalsLock);
+}
+
+/*
+ * Locks the mutex, use the profiled_mutex_lock macro so that the call site is filled in. An acquisition is contended when a try lock fails,
+ * and only then is the clock read before and after waiting, so an uncontended acquisition costs a try lock and one clock read (for the hold time).
+ */
+void profiled_mutex_lock_at(struct profiled_mutex * oMutex, const char * sFunction, int iLine)
+{
+	if(!LOCK_PROFILING)
+	{
+		pthread_mutex_lock(&(oMutex->oMutex));
+		return;
+	}
+	long long int iWaitTime = 0;
+	int iContended = pthread_mutex_trylock(&(oMutex->oMutex)) != 0;
+	if(iContended)
+	{
+		long long int iWaitStart = getTimeInNanoSeconds();
+		pthread_mutex_lock(&(oMutex->oMutex));
+		iWaitTime = getTimeInNanoSeconds() - iWaitStart;
+	}
+	struct lock_site * oSite = lock_site_of(oMutex, sFunction, iLine);
+	oSite->iAcquisitions++;
+	oSite->iContended += iContended;
+	latency_histogram_record(&(oSite->oWaitTime), iWaitTime);
+	oMutex->oHolder = oSite;
+	oMutex->iLockedAt = getTimeInNanoSeconds();
+}
+
+void profiled_mutex_unlock(struct profiled_mutex * oMutex)
+{
+	if(LOCK_PROFILING)
+		profiled_mutex_end_hold(oMutex);
+	pthread_mutex_unlock(&(oMutex->oMutex));
+}
+
+/*
+ * Waits on a condition variable with the mutex held, like pthread_cond_wait. The time asleep is neither hold nor wait time:
+ * the hold ends when the thread goes to sleep, and a new hold for the same call site starts when it wakes up with the mutex.
+ */
+void profiled_mutex_wait(struct profiled_mutex * oMutex, pthread_cond_t * oCondition)
+{
+	if(!LOCK_PROFILING)
+	{
+		pthread_cond_wait(oCondition, &(oMutex->oMutex));
+		return;
+	}
+	struct lock_site * oSite = oMutex->oHolder;
+	profiled_mutex_end_hold(oMutex);
+	pthread_cond_wait(oCondition, &(oMutex->oMutex));
+	oMutex->oHolder = oSite;
+	oMutex->iLockedAt = getTimeInNanoSeconds();
+}
+
+/*
+ * Prints, for every mutex name and call site, the number of acquisitions, the share of them that was contended, and the wait and hold times. Only destroyed mutexes are included.
+ */
+void profiled_mutex_print_stats()
+{
+	struct lock_total * oTotal;
+	pthread_mutex_lock(&oTotalsLock);
+	for(oTotal = oTotals; oTotal != NULL; oTotal = oTotal->oNext)
+	{
+		const struct lock_site * oSite = &(oTotal->oSite);
+		printf("Lock '%s' in %s:%d: %lld acquisitions, %.2f%% contended\n", oTotal->sName, oSite->sFunction, oSite->iLine, oSite->iAcquisitions,
+			oSite->iAcquisitions == 0 ? 0.0 : 100.0 * oSite->iContended / oSite->iAcquisitions);
+		printf("    wait: mean = %lldns, p99 = %lldns, max = %lldns, total = %lldns\n", latency_histogram_mean(&(oSite->oWaitTime)),
+			latency_histogram_percentile(&(oSite->oWaitTime), 99.0), oSite->oWaitTime.iMax, oSite->oWaitTime.iSum);
+		printf("    hold: mean = %lldns, p99 = %lldns, max = %lldns, total = %lldns\n", latency_histogram_mean(&(oSite->oHoldTime)),
+			latency_histogram_percentile(&(oSite->oHoldTime), 99.0), oSite->oHoldTime.iMax, oSite->oHoldTime.iSum);
+	}
+	pthread_mutex_unlock(&oTotalsLock);
+}
+
+/*
+ * Forgets the totals, e.g. between two runs of the benchmark.
+ */
+void profiled_mutex_reset_stats()
+{
+	pthread_mutex_lock(&oTotalsLock);
+	while(oTotals != NULL)
+	{
+		struct lock_total * oTotal = oTotals;
+		oTotals = oTotal->oNext;
+		free(oTotal);
+	}
+	pthread_mutex_unlock(&oTotalsLock);
+}
@@ -0,0 +1,50 @@
+#ifndef PROFILED_MUTEX_H
+#define PROFILED_MUTEX_H
+
+#include <pthread.h>
+#include "posix_utility.h"
+#include "latency_stats.h"
+
+/*
+ * Mutex that profiles itself: for every call site that locks it, it counts the acquisitions and the contended ones (the mutex was held by another thread),
+ * and keeps histograms, in nano seconds, of the time spent waiting for the mutex and of the time it was held.
+ * The statistics of a call site are only updated by the thread that holds the mutex, so profiling takes no lock of its own.
+ * When the mutex is destroyed its statistics are added to those of every other mutex with the same name, and profiled_mutex_print_stats prints the totals.
+ * With LOCK_PROFILING set to 0 a profiled_mutex is a plain pthread mutex and nothing is measured.
+ */
+struct lock_site
+{
+	// function and line of the call site
+	const char * sFunction;
+	int iLine;
+	long long int iAcquisitions;
+	long long int iContended;
+	struct latency_histogram oWaitTime;
+	// a pthread_cond_wait ends a hold and starts a new one, so there can be more holds than acquisitions
+	struct latency_histogram oHoldTime;
+	struct lock_site * oNext;
+};
+
+struct profiled_mutex
+{
+	pthread_mutex_t oMutex;
+	const char * sName;
+	// call sites that locked the mutex so far, allocated the first time they do
+	struct lock_site * oSites;
+	// call site of the thread that holds the mutex, and the time it took it
+	struct lock_site * oHolder;
+	long long int iLockedAt;
+};
+
+void profiled_mutex_init(struct profiled_mutex * oMutex, const char * sName);
+void profiled_mutex_destroy(struct profiled_mutex * oMutex);
+void profiled_mutex_lock_at(struct profiled_mutex * oMutex, const char * sFunction, int iLine);
+void profiled_mutex_unlock(struct profiled_mutex * oMutex);
+void profiled_mutex_wait(struct profiled_mutex * oMutex, pthread_cond_t * oCondition);
+void profiled_mutex_print_stats();
+void profiled_mutex_reset_stats();
+
+// locks the mutex on behalf of the call site it is written at
+#define profiled_mutex_lock(oMutex) profiled_mutex_lock_at((oMutex), __func__, __LINE__)
+
+#endif
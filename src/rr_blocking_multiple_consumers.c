@@ -0,0 +1,337 @@
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <assert.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include "bounded_buffer.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
+
+/*
+    RR Blocking, Bounded & MC (Round Robin with Blocking Processes, Bounding Buffer and Multiple Consumers) Implementation of predefined process (task 5).
+    A process that does not use its whole time slice has blocked on one of NUMBER_OF_EVENT_TYPES events and waits in the queue of that event type.
+    Every event type has a timer (a timerfd) that goes off after a random interval and is armed again. A single event thread waits for all of them in one epoll instance,
+    and moves every process waiting for the event types whose timers went off back to the ready queue at once, however many processes are blocked.
+    Predefined constraints are preprocessor macros in 'posix_utility.h'
+*/
+
+/* pthread functionality requires that all functions ran on a separate thread must return void* and take a single void* parameter.
+however, multiple parameters will be requires, such as a pointer to the ready queue, the bounded buffer etc.
+to solve this, the following structs are used to contain all required data:
+*/
+
+// everything the threads share. the ready queue and the event queues are only touched while the buffer lock is held.
+struct shared_queues
+{
+    struct bounded_buffer buffer;
+    struct run_queue ready_queue;
+    struct run_queue event_queues[NUMBER_OF_EVENT_TYPES];
+    // when every event type last happened, in nano seconds
+    long long int event_fired_at[NUMBER_OF_EVENT_TYPES];
+};
+
+struct creator_pack
+{
+    struct shared_queues* queues;
+    // number of times the creator took the buffer lock to queue its processes.
+    long int lock_acquisitions;
+};
+
+struct consumer_pack
+{
+    unsigned int consumer_id;
+    struct shared_queues* queues;
+    // every consumer records into its own statistics block, so consumers never write to the same memory. they are merged once the consumer has been joined.
+    struct latency_stats stats;
+    // number of times this consumer ran a process
+    long int dispatches;
+};
+
+struct event_pack
+{
+    struct shared_queues* queues;
+    // the epoll instance, the timer of every event type, and an eventfd that tells the event thread to stop.
+    int epoll_fd;
+    int timer_fds[NUMBER_OF_EVENT_TYPES];
+    int stop_fd;
+    unsigned int events_generated;
+    long int processes_woken;
+};
+
+static int is_finished(struct process* a_process)
+{
+    return a_process->iState == FINISHED;
+}
+
+static void* create_processes(void* creator_package)
+{
+    struct creator_pack* creator = (struct creator_pack*) creator_package;
+    // the workload is drawn from a random stream of its own, so it is the same in every run whatever the consumers draw.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    struct shared_queues* queues = creator->queues;
+    // the processes that are being queued. the batch size is only known at run time and may be large, so the batch is not on the stack of the thread.
+    // a batch never holds more processes than fit in the buffer.
+    struct process** batch = (struct process**) calloc(SUBMIT_BATCH_SIZE < BUFFER_SIZE ? SUBMIT_BATCH_SIZE : BUFFER_SIZE, sizeof(struct process*));
+    assert(batch != NULL);
+    size_t processes_created = 0;
+    size_t i;
+    while(processes_created < NUMBER_OF_PROCESSES)
+    {
+        size_t batch_size = NUMBER_OF_PROCESSES - processes_created < (size_t) SUBMIT_BATCH_SIZE ? NUMBER_OF_PROCESSES - processes_created : (size_t) SUBMIT_BATCH_SIZE;
+        // a replayed job that has not arrived yet is waited for before taking the lock, so that waiting never holds up the consumers.
+        waitForNextArrival();
+        // sleeps in bounded_buffer_begin_add_batch while the buffer is full, then only generates as many processes as there is space for, so a process never waits outside the buffer once it exists.
+        // generating a process takes no more than a pool allocation and a few random numbers, so it is done while the lock is held.
+        batch_size = bounded_buffer_begin_add_batch(&queues->buffer, batch_size);
+        size_t added = generateProcesses(batch, batch_size);
+        for(i = 0; i < added; i++)
+        {
+            run_queue_push_back(&queues->ready_queue, batch[i]);
+        }
+        bounded_buffer_end_add_batch(&queues->buffer, added);
+        creator->lock_acquisitions++;
+        processes_created += added;
+    }
+    bounded_buffer_close(&queues->buffer);
+    free(batch);
+    pthread_exit(NULL);
+    // Kill the thread. We're done creating processes.
+}
+
+// Sets the timer of an event type to go off once, between 1 and MAX_EVENT_INTERVAL milli seconds from now.
+static void arm_event_timer(int timer_fd)
+{
+    long int interval = (1 + generateRandomNumber(MAX_EVENT_INTERVAL)) * 1000000L;
+    struct itimerspec timer;
+    memset(&timer, 0, sizeof(timer));
+    timer.it_value.tv_sec = interval / 1000000000L;
+    timer.it_value.tv_nsec = interval % 1000000000L;
+    int set = timerfd_settime(timer_fd, 0, &timer, (void*)0);
+    assert(set == 0);
+}
+
+// Waits for the timers of the event types until it is told to stop. the event types whose timers went off together are handled under one acquisition of the buffer lock.
+static void* generate_events(void* event_package)
+{
+    struct event_pack* events = (struct event_pack*) event_package;
+    setRandomStream(RANDOM_STREAM_EVENTS);
+    struct shared_queues* queues = events->queues;
+    struct epoll_event ready[NUMBER_OF_EVENT_TYPES + 1];
+    int i;
+    for(i = 0; i < NUMBER_OF_EVENT_TYPES; i++)
+        arm_event_timer(events->timer_fds[i]);
+    while(1)
+    {
+        int count = epoll_wait(events->epoll_fd, ready, NUMBER_OF_EVENT_TYPES + 1, -1);
+        if(count < 0)
+            continue;
+        int fired[NUMBER_OF_EVENT_TYPES];
+        int fired_count = 0;
+        int stop = 0;
+        for(i = 0; i < count; i++)
+        {
+            int event_type = (int) ready[i].data.u32;
+            if(event_type == NUMBER_OF_EVENT_TYPES)
+            {
+                stop = 1;
+                continue;
+            }
+            uint64_t expirations;
+            // the timers are non blocking, another wake up may already have read this expiration.
+            if(read(events->timer_fds[event_type], &expirations, sizeof(expirations)) == sizeof(expirations))
+                fired[fired_count++] = event_type;
+        }
+        if(stop)
+            break;
+        if(fired_count == 0)
+            continue;
+        // everything that was waiting for these events is ready again. every queue moves in one go, and waiting consumers are woken up by end_requeue.
+        size_t unblocked = 0;
+        bounded_buffer_begin_requeue(&queues->buffer);
+        long long int fired_at = getTimeInNanoSeconds();
+        for(i = 0; i < fired_count; i++)
+        {
+            queues->event_fired_at[fired[i]] = fired_at;
+            unblocked += run_queue_length(&queues->event_queues[fired[i]]);
+            run_queue_splice(&queues->ready_queue, &queues->event_queues[fired[i]]);
+        }
+        bounded_buffer_end_requeue(&queues->buffer, unblocked);
+        for(i = 0; i < fired_count; i++)
+            arm_event_timer(events->timer_fds[fired[i]]);
+        events->events_generated += fired_count;
+        events->processes_woken += unblocked;
+    }
+    pthread_exit(NULL);
+}
+
+static void* consume_processes(void* consumer_package)
+{
+    struct consumer_pack* consumer = (struct consumer_pack*) consumer_package;
+    // whether a process blocks is drawn from the stream of the consumer that runs it.
+    setRandomStream(RANDOM_STREAM_CONSUMER(consumer->consumer_id));
+    struct shared_queues* queues = consumer->queues;
+    // thread does not die until we're no longer creating more and every process has finished.
+    // while every live process is blocked the thread sleeps in bounded_buffer_begin_take until the event thread wakes it up.
+    while(bounded_buffer_begin_take(&queues->buffer))
+    {
+        // there is a ready process, from here on until it runs the time goes to selecting it.
+        long long int selecting = getTimeInNanoSeconds();
+        struct process* begin = run_queue_pop_front(&queues->ready_queue);
+        // processes that were unblocked are set back to ready here rather than in the event generator, so moving a queue stays O(1).
+        // for the same reason their ready time is that of the last occurrence of their event, which is later than the one that woke them up if the event happened again in the meantime.
+        if(begin->iState == BLOCKED)
+        {
+            begin->iState = READY;
+            begin->iReadySince = queues->event_fired_at[begin->iEventType];
+        }
+        bounded_buffer_end_take(&queues->buffer);
+        struct timeval start, end;
+        int previous_burst = begin->iBurstTime;
+        int already_running = begin->iState != NEW;
+        long long int ready_since = begin->iReadySince;
+        long long int running = getTimeInNanoSeconds();
+        simulateBlockingRoundRobinProcess(begin, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        consumer->dispatches++;
+        unsigned int response_time = getDifferenceInMilliSeconds(begin->oTimeCreated, start);
+        // the writer thread formats and prints the line, the consumer only copies the event into its own ring.
+        trace_log_dispatch(consumer->consumer_id, begin, previous_burst, !already_running, start, end);
+        if(!already_running)
+        {
+            latency_stats_record_response(&consumer->stats, response_time);
+        }
+        if(is_finished(begin))
+        {
+            unsigned int turnaround_time = getDifferenceInMilliSeconds(begin->oTimeCreated, end);
+            latency_stats_record_completion(&consumer->stats, turnaround_time, begin->iInitialBurstTime);
+            process_release(begin);
+            bounded_buffer_retire(&queues->buffer);
+        }
+        else if(begin->iState == BLOCKED)
+        {
+            // blocked, wait in the queue of its event. it is not ready so no consumer is woken up.
+            bounded_buffer_begin_requeue(&queues->buffer);
+            run_queue_push_back(&queues->event_queues[begin->iEventType], begin);
+            bounded_buffer_end_requeue(&queues->buffer, 0);
+        }
+        else
+        {
+            // used its whole time slice, back to the end of the ready queue.
+            bounded_buffer_begin_requeue(&queues->buffer);
+            begin->iReadySince = getTimeInNanoSeconds();
+            run_queue_push_back(&queues->ready_queue, begin);
+            bounded_buffer_end_requeue(&queues->buffer, 1);
+        }
+        latency_stats_record_dispatch(&consumer->stats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
+    }
+    pthread_exit(NULL);
+    // Kill the thread.
+}
+
+void run_rr_blocking_multiple_consumers(struct scheduler_result* result)
+{
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
+    unsigned int i;
+    struct shared_queues queues;
+    bounded_buffer_init(&queues.buffer, BUFFER_SIZE);
+    run_queue_init(&queues.ready_queue);
+    for(i = 0; i < NUMBER_OF_EVENT_TYPES; i++)
+    {
+        run_queue_init(&queues.event_queues[i]);
+        queues.event_fired_at[i] = 0;
+    }
+    pthread_t creator_thread_handle, event_thread_handle;
+    pthread_t* consumer_thread_handle = (pthread_t*) calloc(NUMBER_OF_CONSUMERS, sizeof(pthread_t));
+    struct creator_pack creator;
+    creator.queues = &queues;
+    creator.lock_acquisitions = 0;
+    pthread_create(&creator_thread_handle, NULL, create_processes, &creator);
+    struct event_pack events;
+    events.queues = &queues;
+    events.events_generated = 0;
+    events.processes_woken = 0;
+    events.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    assert(events.epoll_fd >= 0);
+    // the event type is the data of its timer, the stop eventfd comes after the last one.
+    struct epoll_event watched;
+    memset(&watched, 0, sizeof(watched));
+    watched.events = EPOLLIN;
+    for(i = 0; i < NUMBER_OF_EVENT_TYPES; i++)
+    {
+        events.timer_fds[i] = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        assert(events.timer_fds[i] >= 0);
+        watched.data.u32 = i;
+        epoll_ctl(events.epoll_fd, EPOLL_CTL_ADD, events.timer_fds[i], &watched);
+    }
+    events.stop_fd = eventfd(0, EFD_CLOEXEC);
+    assert(events.stop_fd >= 0);
+    watched.data.u32 = NUMBER_OF_EVENT_TYPES;
+    epoll_ctl(events.epoll_fd, EPOLL_CTL_ADD, events.stop_fd, &watched);
+    pthread_create(&event_thread_handle, NULL, generate_events, &events);
+    // the packs are on the heap: each of them holds the latency histograms of its consumer, and hundreds of consumers would not fit on the stack.
+    struct consumer_pack* consumer = (struct consumer_pack*) calloc(NUMBER_OF_CONSUMERS, sizeof(struct consumer_pack));
+    assert(consumer != NULL && consumer_thread_handle != NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        consumer[i].consumer_id = i;
+        consumer[i].queues = &queues;
+        latency_stats_init(&consumer[i].stats);
+        consumer[i].dispatches = 0;
+        pthread_create(&consumer_thread_handle[i], NULL, consume_processes, &consumer[i]);
+    }
+
+    pthread_join(creator_thread_handle, NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        pthread_join(consumer_thread_handle[i], NULL);
+        latency_stats_merge(&result->oStats, &consumer[i].stats);
+        result->iDispatches += consumer[i].dispatches;
+    }
+    // the consumers only stop once every process has finished, nothing is blocked anymore.
+    uint64_t stop = 1;
+    ssize_t written = write(events.stop_fd, &stop, sizeof(stop));
+    assert(written == sizeof(stop));
+    pthread_join(event_thread_handle, NULL);
+    for(i = 0; i < NUMBER_OF_EVENT_TYPES; i++)
+        close(events.timer_fds[i]);
+    close(events.stop_fd);
+    close(events.epoll_fd);
+    bounded_buffer_destroy(&queues.buffer);
+    printf("%d processes submitted in %ld lock acquisitions (%.2f per process)\n", NUMBER_OF_PROCESSES, creator.lock_acquisitions, (double) creator.lock_acquisitions / NUMBER_OF_PROCESSES);
+    printf("%d events generated, %ld processes woken up by them\n", events.events_generated, events.processes_woken);
+    free(consumer);
+    free(consumer_thread_handle);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    run_rr_blocking_multiple_consumers(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
+    profiled_mutex_print_stats();
+    return 0;
+}
+#endif
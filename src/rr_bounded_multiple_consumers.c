@@ -2,301 +2,253 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sched.h>
 #include <pthread.h>
 #include <assert.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "mpmc_ring.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
 
 /*
     RR Bounded & MC (Shortest-Job-First with Bounding Buffer and Multiple Consumers) Implementation of predefined process.
+    Every consumer has a local ready queue of its own (a lock-free ring), which the creator distributes the processes into.
+    A consumer puts a preempted process back at the end of its own queue, and when its queue is empty it steals the oldest process of a randomly chosen other consumer.
     Predefined constraints are preprocessor macros in 'posix_utility.h'
 */
 
-// Using this as a helper function
-void swap(struct process** left, struct process** right)
-{
-    struct process* temp = *left;
-    *left = *right;
-    *right = temp;
-}
-
-// Quick and dirty way to get size of linked list. size_t as opposed to unsigned int as values inputted into things like operator[] are not unsigned ints, and do have different limits.
-// size_t declared in stdlib.h and stddef.h iirc.
-size_t list_size(struct process* head)
-{
-    size_t size = 0;
-    while(head != (void*)0)
-    {
-        size++;
-        head = head->oNext;
-    }
-    return size;
-}
-
-int is_locked(pthread_mutex_t* mutex)
-{
-    int ret = 1;
-    if(pthread_mutex_trylock(mutex) == 0)
-    {
-       // successfully locked, i.e the mutex was not locked beforehand.
-       ret = 0;
-       pthread_mutex_unlock(mutex);
-    }
-    return ret;
-}
-
-void print_list(struct process* head)
-{
-    struct process* iter = head;
-    int i;
-    for(i = 0; i < list_size(head); i++)
-    {
-        printf("[%d] pid = %d\n", i, iter->iProcessId);
-        iter = iter->oNext;
-    }
-}
-
 /* pthread functionality requires that all functions ran on a separate thread must return void* and take a single void* parameter.
-however, multiple parameters will be requires, such as a pointer to the head of the process list, a mutex lock etc.
+however, multiple parameters will be requires, such as a pointer to the ready queues, the semaphores etc.
 to solve this, the following structs are used to contain all required data:
 */
 
 struct creator_pack
 {
-    pthread_mutex_t* mutex_handle;
-    // This is the shared data. Although this is just a copy of a pointer, the data being pointed to is the shared data.
-    // Therefore whenever consumer runs or edits any process in the list in anyway, mutex lock must be invoked during such execution.
-    struct process** head;
-    unsigned int* creating_finished;
+    // This is the shared data, one queue per consumer. The queues are lock-free rings, so the creator, the owner and thieves never wait on each other to add or take a process.
+    struct mpmc_ring* local_queues;
+    // counts the space left in the bounded buffer. a process takes a slot when it is created and gives it back when it finishes.
+    sem_t* free_slots;
+    // counts the processes in all the local queues together, so consumers can sleep until there is one.
+    sem_t* queued_processes;
 };
 
 struct consumer_pack
 {
-    pthread_mutex_t* mutex_handle;
     unsigned int consumer_id;
     // still is the shared data.
-    // head is a double ptr because the head position will change alot.
-    struct process** head;
-    struct process* tail;
-    unsigned int* creating_finished;
-    // Want to access the totals values to edit them with any consumption of processes performed.
-    unsigned int* total_response_time;
-    unsigned int* total_turnaround_time;
+    struct mpmc_ring* local_queues;
+    sem_t* free_slots;
+    sem_t* queued_processes;
+    // processes which have not finished yet. the consumer that finishes the last one wakes every consumer up so they can exit.
+    atomic_int* processes_left;
+    unsigned int processes_stolen;
+    // every consumer records into its own statistics block, so consumers never write to the same memory. they are merged once the consumer has been joined.
+    struct latency_stats stats;
+    // number of times this consumer ran a process
+    long int dispatches;
 };
 
-// RR, add the process to the end of the list. edits the list so MUST be mutex locked.
-void add_process(pthread_mutex_t* lock, struct process** head, struct process* a_process)
+// RR, add the process to the end of a local queue and wake up a consumer. a single atomic enqueue, no lock.
+// every ring is at least BUFFER_SIZE big and there are never more than BUFFER_SIZE live processes, so it cannot be full.
+static void add_process(struct mpmc_ring* queue, sem_t* queued_processes, struct process* a_process)
 {
-    pthread_mutex_lock(lock);
-    struct process* head_cpy = *head;
-    if(head_cpy == (void*)0)
-        *head = a_process;
-    while(head_cpy->oNext != (void*)0)
-    {
-        head_cpy = head_cpy->oNext;
-    }
-    head_cpy->oNext = a_process;
-    pthread_mutex_unlock(lock);
+    int added = mpmc_ring_enqueue(queue, a_process);
+    assert(added);
+    sem_post(queued_processes);
 }
 
-// Must be ran on a creator package where the process head is just one element.
-void* create_processes(void* creator_package)
+// RR, take the process at the front of our own queue, or steal one if it is empty. sleeps until there is one. returns (void*)0 once every process has finished.
+// selecting is set to the time the consumer got the token of a process and started looking for it.
+static struct process* remove_process(struct consumer_pack* consumer, long long int* selecting)
 {
-    struct creator_pack* creator = (struct creator_pack*) creator_package;
-    printf("Asserting list_size == 1...\n");
-    assert(list_size(*creator->head) == 1);
-    size_t processes_created = 1;
-    while(processes_created < NUMBER_OF_PROCESSES)
+    const unsigned int cid = consumer->consumer_id;
+    unsigned int i;
+    // every process in the queues has a token in the semaphore, so once we got one there is a process waiting somewhere for us.
+    sem_wait(consumer->queued_processes);
+    *selecting = getTimeInNanoSeconds();
+    while(1)
     {
-        // this thread keeps trying to create new processes until the number of processes made in total is what we need.
-        if(list_size(*creator->head) <= BUFFER_SIZE)
+        struct process* front = mpmc_ring_dequeue(&consumer->local_queues[cid]);
+        if(front != (void*)0)
+            return front;
+        // start at a random victim so the thieves do not all go for the same queue.
+        unsigned int first_victim = generateRandomNumber(NUMBER_OF_CONSUMERS);
+        for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
         {
-            // we have space to generate a new process, so do so.
-            struct process* new_process = generateProcess();
-            add_process(creator->mutex_handle, creator->head, new_process);
-            processes_created++;
+            unsigned int victim = (first_victim + i) % NUMBER_OF_CONSUMERS;
+            if(victim == cid)
+                continue;
+            front = mpmc_ring_dequeue(&consumer->local_queues[victim]);
+            if(front != (void*)0)
+            {
+                consumer->processes_stolen++;
+                return front;
+            }
         }
+        if(atomic_load(consumer->processes_left) == 0)
+            return (void*)0;
+        // the process we were woken up for has been claimed by a creator or consumer that has not published it yet, or was taken from a queue we had already looked at. look again.
+        sched_yield();
     }
-    pthread_mutex_lock(creator->mutex_handle);
-    *(creator->creating_finished) = 1;
-    pthread_mutex_unlock(creator->mutex_handle);
-    // Make the bool true so the other thread can safely read. Shouldn't need to mutex this.
-    pthread_exit(NULL);
-    // Kill the thread. We're done creating processes.
 }
 
-// Take double pointer to head remains true. edits the list so MUST be locked!
-void remove_process(pthread_mutex_t* lock, struct process** head, struct process* to_remove)
+static int is_finished(struct process* a_process)
 {
-    pthread_mutex_lock(lock);
-    struct process* process_head = *head;
-    if(process_head == (void*)0)
-    {
-        pthread_mutex_unlock(lock);
-        return;
-    }
-    if(process_head == to_remove)
-    {
-        struct process* tmp = process_head;
-        *head = process_head->oNext;
-        free(process_head);
-        //print_list(*head);
-        pthread_mutex_unlock(lock);
-        return;
-    }
-    struct process* previous = process_head;
-    while(process_head != (void*)0)
+    return a_process->iState == FINISHED;
+}
+
+static void* create_processes(void* creator_package)
+{
+    struct creator_pack* creator = (struct creator_pack*) creator_package;
+    // the workload is drawn from a random stream of its own, so it is the same in every run whatever the consumers draw.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    size_t processes_created = 0;
+    while(processes_created < NUMBER_OF_PROCESSES)
     {
-        if(process_head == to_remove)
-        {
-            if(to_remove != (void*)0)
-                process_head = to_remove;
-            previous->oNext = process_head->oNext;
-            free(to_remove);
-            //print_list(*head);
-            pthread_mutex_unlock(lock);
-            return;
-        }
-        previous = process_head;
-        process_head = process_head->oNext;
+        // this thread keeps creating new processes until the number of processes made in total is what we need.
+        // sleeps while the buffer is full.
+        sem_wait(creator->free_slots);
+        struct process* new_process = generateProcess();
+        // hand the processes out to the consumers in turn.
+        add_process(&creator->local_queues[processes_created % NUMBER_OF_CONSUMERS], creator->queued_processes, new_process);
+        processes_created++;
     }
-    pthread_mutex_unlock(lock);
+    pthread_exit(NULL);
+    // Kill the thread. We're done creating processes.
 }
 
-void* consume_processes(void* consumer_package)
+static void* consume_processes(void* consumer_package)
 {
     struct consumer_pack* consumer = (struct consumer_pack*) consumer_package;
-    const unsigned int cid = consumer->consumer_id;
+    // the victims to steal from are drawn from the stream of the consumer.
+    setRandomStream(RANDOM_STREAM_CONSUMER(consumer->consumer_id));
+    struct process* begin;
+    long long int selecting;
     unsigned int i;
-    // because multiple consumers, we dont want to ever actually lock the mutex, just check if its already locked by the creator and sleep if it is.
-    while(*(consumer->creating_finished) == 0 || list_size(*consumer->head) > 0) // thread does not die until we're no longer creating more and the list is completely empty.
+    // every consumer takes the process at the front of its queue, runs it for a time slice and puts it back at the end of its own queue if it has not finished.
+    // thread does not die until every process has finished. while there is nothing to do it sleeps in remove_process.
+    while((begin = remove_process(consumer, &selecting)) != (void*)0)
     {
-        // if were not done and we have one more, do not kill the last one
-        // but if we are done and have one more, than we can kill the last one
-        if(*(consumer->creating_finished) == 0 && list_size(*consumer->head) <= 1)
-        {
-            //printf("list size is 1 or less, waiting...\n");
-            //printf("creation finished = %d, list_size = %d\n", *(consumer->creating_finished), list_size(*consumer->head));
-            //sleep(1);
-            continue;
-        }
-        struct process* begin = *consumer->head;
-        int is_ready = 1;
-        for(i = 0; i < cid; i++)
-        {
-            if(list_size(*consumer->head) == 0 || begin->oNext == NULL)
-                is_ready = 0;
-            else
-                begin = begin->oNext;
-        }
-        // move begin to cid position in the list. so if cid = 1, cid is the 1st (not 0th) element of the linked list.
-        if(is_ready == 0)
-        {
-            //printf("cid %d not ready to process... list size = %d\n", cid, list_size(*consumer->head));
-            //sleep(1);
-            continue;
-        }
-        if(is_locked(consumer->mutex_handle))
-        {
-            // wait if creation is happening right now or list size is too small.
-            // currently creating more. dont do anything.
-            continue;
-        }
-        // no creation is taking place by now, the list size is fair and our element in the list is valid.
-        //pthread_mutex_lock(consumer->mutex_handle);
-        //printf("cid = %d, head pid = %d, pid to kill = %d\n", cid, (*consumer->head)->iProcessId, begin->iProcessId);
+        // the process is out of the ready queue so this thread owns it until it is put back.
         struct timeval start, end;
         int previous_burst = begin->iBurstTime;
         int already_running = 0;
         if(begin->iState == RUNNING || begin->iState == READY)
             already_running = 1;
+        long long int ready_since = begin->iReadySince;
+        long long int running = getTimeInNanoSeconds();
         simulateRoundRobinProcess(begin, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        consumer->dispatches++;
         unsigned int response_time = getDifferenceInMilliSeconds(begin->oTimeCreated, start);
-        printf("pid = %d, previous burst = %d, new burst = %d", begin->iProcessId, previous_burst, begin->iBurstTime);
+        // the writer thread formats and prints the line, the consumer only copies the event into its own ring.
+        trace_log_dispatch(consumer->consumer_id, begin, previous_burst, !already_running, start, end);
         if(!already_running)
         {
-            printf(", response time = %ld", response_time);
-            *(consumer->total_response_time) += response_time;
+            latency_stats_record_response(&consumer->stats, response_time);
         }
-        // now delete it.
         if(is_finished(begin))
         {
+            // now delete it.
             unsigned int turnaround_time = getDifferenceInMilliSeconds(begin->oTimeCreated, end);
-            printf(", turnaround time = %ld", turnaround_time);
-            //printf("\nprocess being killed. process list size = %d\n", list_size(*consumer->head));
-            *(consumer->total_turnaround_time) += turnaround_time;
-            remove_process(consumer->mutex_handle, consumer->head, begin);
+            latency_stats_record_completion(&consumer->stats, turnaround_time, begin->iInitialBurstTime);
+            process_release(begin);
+            sem_post(consumer->free_slots);
+            if(atomic_fetch_sub(consumer->processes_left, 1) == 1)
+            {
+                // that was the last one, wake up every consumer so they see there is nothing left.
+                for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+                    sem_post(consumer->queued_processes);
+            }
+        }
+        else
+        {
+            // used its whole time slice, back to the end of our own queue.
+            begin->iReadySince = getTimeInNanoSeconds();
+            add_process(&consumer->local_queues[consumer->consumer_id], consumer->queued_processes, begin);
         }
-        printf("\n");
-        //printf("finished removing process.\n");
-        //printf("list size = %d, done = %d\n", list_size(*consumer->head), *(consumer->creating_finished));
-        //pthread_mutex_unlock(consumer->mutex_handle);
+        latency_stats_record_dispatch(&consumer->stats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
     }
     pthread_exit(NULL);
     // Kill the thread.
 }
 
-int is_finished(struct process* a_process)
+void run_rr_bounded_multiple_consumers(struct scheduler_result* result)
 {
-    return a_process->iState == FINISHED;
-}
-
-int all_finished(struct process* process_head)
-{
-    while(process_head != (void*)0)
-    {
-        if(process_head->iState != FINISHED)
-            return 0;
-        process_head = process_head->oNext;
-    }
-    return 1;
-}
-
-int main()
-{
-    unsigned int total_turnaround_time = 0;
-    unsigned int total_response_time = 0;
-    // Give me a process. Linked List is currently sorted as contains one element.
-    struct process* process_head = generateProcess();
-    struct process* process_tail = process_head;
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
     unsigned int i;
-    // make number of processes we've allocated equal to the macro
-    /*
-    for(i = 0; i < NUMBER_OF_PROCESSES; i++)
-    {
-        struct process* a_process = generateProcess();
-        add_process(process_head, a_process);
-        process_tail = a_process;
-    }
-    */
-    unsigned int create_done = 0;
-    pthread_mutex_t lock;
-    pthread_t creator_thread_handle, consumer_thread_handle[NUMBER_OF_CONSUMERS];
+    // the queues sit on cache lines of their own, so they take aligned memory.
+    struct mpmc_ring* local_queues = (struct mpmc_ring*) aligned_alloc(CACHE_LINE_SIZE, NUMBER_OF_CONSUMERS * sizeof(struct mpmc_ring));
+    assert(local_queues != NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+        mpmc_ring_init(&local_queues[i], BUFFER_SIZE);
+    sem_t free_slots, queued_processes;
+    sem_init(&free_slots, 0, BUFFER_SIZE);
+    sem_init(&queued_processes, 0, 0);
+    atomic_int processes_left = NUMBER_OF_PROCESSES;
+    pthread_t creator_thread_handle;
+    pthread_t* consumer_thread_handle = (pthread_t*) calloc(NUMBER_OF_CONSUMERS, sizeof(pthread_t));
     struct creator_pack creator;
-    creator.mutex_handle = &lock;
-    creator.head = &process_head;
-    creator.creating_finished = &create_done;
+    creator.local_queues = local_queues;
+    creator.free_slots = &free_slots;
+    creator.queued_processes = &queued_processes;
     pthread_create(&creator_thread_handle, NULL, create_processes, &creator);
-    struct consumer_pack consumer[NUMBER_OF_CONSUMERS];
+    // the packs are on the heap: each of them holds the latency histograms of its consumer, and hundreds of consumers would not fit on the stack.
+    struct consumer_pack* consumer = (struct consumer_pack*) calloc(NUMBER_OF_CONSUMERS, sizeof(struct consumer_pack));
+    assert(consumer != NULL && consumer_thread_handle != NULL);
     for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
     {
-        consumer[i].mutex_handle = &lock;
         consumer[i].consumer_id = i;
-        consumer[i].head = &process_head;
-        consumer[i].tail = process_tail;
-        consumer[i].creating_finished = &create_done;
-        consumer[i].total_response_time = &total_response_time;
-        consumer[i].total_turnaround_time = &total_turnaround_time;
+        consumer[i].local_queues = local_queues;
+        consumer[i].free_slots = &free_slots;
+        consumer[i].queued_processes = &queued_processes;
+        consumer[i].processes_left = &processes_left;
+        consumer[i].processes_stolen = 0;
+        latency_stats_init(&consumer[i].stats);
+        consumer[i].dispatches = 0;
         pthread_create(&consumer_thread_handle[i], NULL, consume_processes, &consumer[i]);
     }
-    // Creator thread separate. Consumption thread unnecessary as that will be done in the main thread.
-    // The reason I do not create another thread for consumption as the main thread will just wait for it anyway so might aswell use it.
 
     pthread_join(creator_thread_handle, NULL);
-    //printf("creator thread joined.\n");
     for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
     {
         pthread_join(consumer_thread_handle[i], NULL);
-        //printf("consumer thread joined.\n");
+        latency_stats_merge(&result->oStats, &consumer[i].stats);
+        result->iDispatches += consumer[i].dispatches;
+        printf("cid = %d stole %d processes\n", i, consumer[i].processes_stolen);
     }
-    printf("Done. Average Response Time = %ldms, Average Turnaround Time = %ldms\n", total_response_time / NUMBER_OF_PROCESSES, total_turnaround_time / NUMBER_OF_PROCESSES);
+    sem_destroy(&queued_processes);
+    sem_destroy(&free_slots);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+        mpmc_ring_destroy(&local_queues[i]);
+    free(consumer);
+    free(consumer_thread_handle);
+    free(local_queues);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    run_rr_bounded_multiple_consumers(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,339 @@
+// pthread_setaffinity_np and the CPU_* macros are GNU extensions
+#define _GNU_SOURCE
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "profiled_mutex.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
+
+/*
+    RR Per-CPU, Bounded & MC (Round Robin with Per-CPU Run Queues, Bounding Buffer and Multiple Consumers) Implementation of predefined process.
+    Every consumer stands for a CPU: it is pinned to a CPU of its own (PER_CPU_PINNING) and only ever runs processes from its own run queue.
+    The creator hands the processes out to the run queues in turn. Every LOAD_BALANCE_INTERVAL milli seconds a load balancer compares the lengths of the run queues,
+    and when the longest one has at least LOAD_BALANCE_THRESHOLD more processes than the shortest one, it migrates half the difference from the end of the one to the end of the other.
+    A migrated process pays MIGRATION_COST milli seconds the first time it runs on its new CPU, which models the cache and TLB misses of moving between cores.
+    Besides the latencies, the migrations and the utilization of every CPU are reported.
+    Predefined constraints are preprocessor macros in 'posix_utility.h'
+*/
+
+// the run queue of a CPU. every run queue has its own lock and sits on its own cache lines, so CPUs only contend with the creator and the load balancer.
+struct cpu_queue
+{
+    _Alignas(CACHE_LINE_SIZE) struct profiled_mutex lock;
+    // signalled when a process is added, and when the last process has finished.
+    pthread_cond_t not_empty;
+    struct run_queue run_queue;
+};
+
+/* pthread functionality requires that all functions ran on a separate thread must return void* and take a single void* parameter.
+however, multiple parameters will be requires, such as a pointer to the run queues, the semaphore etc.
+to solve this, the following structs are used to contain all required data:
+*/
+
+struct creator_pack
+{
+    struct cpu_queue* cpu_queues;
+    // counts the space left in the bounded buffer. a process takes a slot when it is created and gives it back when it finishes.
+    sem_t* free_slots;
+};
+
+struct consumer_pack
+{
+    unsigned int consumer_id;
+    struct cpu_queue* cpu_queues;
+    sem_t* free_slots;
+    // processes which have not finished yet. the consumer that finishes the last one wakes every consumer up so they can exit.
+    atomic_int* processes_left;
+    // micro seconds this CPU spent running processes, including the cost of migrations.
+    long long int busy_time;
+    // number of times this CPU ran a process that had run on another CPU before.
+    long int migrated_runs;
+    // every consumer records into its own statistics block, so consumers never write to the same memory. they are merged once the consumer has been joined.
+    struct latency_stats stats;
+    // number of times this consumer ran a process
+    long int dispatches;
+};
+
+struct balancer_pack
+{
+    struct cpu_queue* cpu_queues;
+    atomic_int* processes_left;
+    long int migrations;
+    long int rounds;
+};
+
+static int is_finished(struct process* a_process)
+{
+    return a_process->iState == FINISHED;
+}
+
+static long long int microseconds_between(struct timeval start, struct timeval end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_usec - start.tv_usec);
+}
+
+// adds the process at the end of the run queue of a CPU and wakes the CPU up.
+static void add_process(struct cpu_queue* queue, struct process* a_process)
+{
+    profiled_mutex_lock(&queue->lock);
+    run_queue_push_back(&queue->run_queue, a_process);
+    pthread_cond_signal(&queue->not_empty);
+    profiled_mutex_unlock(&queue->lock);
+}
+
+// takes the process at the front of our own run queue, sleeping until there is one. returns (void*)0 once every process has finished.
+// selecting is set to the time the CPU found a process in its queue and started selecting.
+static struct process* remove_process(struct consumer_pack* consumer, long long int* selecting)
+{
+    struct cpu_queue* queue = &consumer->cpu_queues[consumer->consumer_id];
+    profiled_mutex_lock(&queue->lock);
+    while(run_queue_length(&queue->run_queue) == 0 && atomic_load(consumer->processes_left) > 0)
+        profiled_mutex_wait(&queue->lock, &queue->not_empty);
+    *selecting = getTimeInNanoSeconds();
+    struct process* front = run_queue_pop_front(&queue->run_queue);
+    profiled_mutex_unlock(&queue->lock);
+    return front;
+}
+
+// pins the calling thread to a CPU. on failure the thread just floats, the run still works.
+static void pin_to_cpu(unsigned int consumer_id)
+{
+    long int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(consumer_id % (cpus > 0 ? cpus : 1), &cpu_set);
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if(error != 0)
+        fprintf(stderr, "consumer %u could not be pinned to a CPU (error %d)\n", consumer_id, error);
+}
+
+static void* create_processes(void* creator_package)
+{
+    struct creator_pack* creator = (struct creator_pack*) creator_package;
+    // the workload is drawn from a random stream of its own, so it is the same in every run whatever the consumers draw.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    size_t processes_created = 0;
+    while(processes_created < NUMBER_OF_PROCESSES)
+    {
+        // sleeps while the buffer is full.
+        sem_wait(creator->free_slots);
+        struct process* new_process = generateProcess();
+        // hand the processes out to the CPUs in turn, the load balancer evens out what that gets wrong.
+        add_process(&creator->cpu_queues[processes_created % NUMBER_OF_CONSUMERS], new_process);
+        processes_created++;
+    }
+    pthread_exit(NULL);
+    // Kill the thread. We're done creating processes.
+}
+
+// Every LOAD_BALANCE_INTERVAL, moves processes from the longest run queue to the shortest one, until every process has finished.
+static void* balance_load(void* balancer_package)
+{
+    struct balancer_pack* balancer = (struct balancer_pack*) balancer_package;
+    struct cpu_queue* cpu_queues = balancer->cpu_queues;
+    unsigned int i;
+    while(atomic_load(balancer->processes_left) > 0)
+    {
+        usleep(LOAD_BALANCE_INTERVAL * 1000);
+        // the queues are always locked in the same order, and consumers never hold more than one lock, so this cannot deadlock.
+        for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+            profiled_mutex_lock(&cpu_queues[i].lock);
+        unsigned int busiest = 0, idlest = 0;
+        for(i = 1; i < NUMBER_OF_CONSUMERS; i++)
+        {
+            if(run_queue_length(&cpu_queues[i].run_queue) > run_queue_length(&cpu_queues[busiest].run_queue))
+                busiest = i;
+            if(run_queue_length(&cpu_queues[i].run_queue) < run_queue_length(&cpu_queues[idlest].run_queue))
+                idlest = i;
+        }
+        size_t imbalance = run_queue_length(&cpu_queues[busiest].run_queue) - run_queue_length(&cpu_queues[idlest].run_queue);
+        if(imbalance >= LOAD_BALANCE_THRESHOLD)
+        {
+            // the processes at the end of the queue have waited the shortest and will not run for a while on their old CPU anyway.
+            size_t moves = imbalance / 2;
+            for(i = 0; i < moves; i++)
+            {
+                struct process* migrant = cpu_queues[busiest].run_queue.oTail;
+                run_queue_unlink(&cpu_queues[busiest].run_queue, migrant);
+                run_queue_push_back(&cpu_queues[idlest].run_queue, migrant);
+            }
+            balancer->migrations += moves;
+            pthread_cond_broadcast(&cpu_queues[idlest].not_empty);
+        }
+        balancer->rounds++;
+        for(i = NUMBER_OF_CONSUMERS; i-- > 0; )
+            profiled_mutex_unlock(&cpu_queues[i].lock);
+    }
+    pthread_exit(NULL);
+}
+
+static void* consume_processes(void* consumer_package)
+{
+    struct consumer_pack* consumer = (struct consumer_pack*) consumer_package;
+    struct process* begin;
+    long long int selecting;
+    unsigned int i;
+    if(PER_CPU_PINNING)
+        pin_to_cpu(consumer->consumer_id);
+    // thread does not die until every process has finished. while its run queue is empty it sleeps in remove_process.
+    while((begin = remove_process(consumer, &selecting)) != (void*)0)
+    {
+        struct timeval start, end;
+        long long int ready_since = begin->iReadySince;
+        // warming up after a migration counts as running, not as the cost of the scheduler.
+        long long int running = getTimeInNanoSeconds();
+        if(begin->iCpu >= 0 && begin->iCpu != (int) consumer->consumer_id)
+        {
+            // the process ran on another CPU before, it pays for warming up the caches of this one before it gets anything done.
+            struct timeval warm_start, warm_end;
+            runProcess(MIGRATION_COST, &warm_start, &warm_end);
+            consumer->busy_time += microseconds_between(warm_start, warm_end);
+            consumer->migrated_runs++;
+        }
+        begin->iCpu = consumer->consumer_id;
+        int previous_burst = begin->iBurstTime;
+        int already_running = begin->iState != NEW;
+        simulateRoundRobinProcess(begin, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        consumer->dispatches++;
+        consumer->busy_time += microseconds_between(start, end);
+        unsigned int response_time = getDifferenceInMilliSeconds(begin->oTimeCreated, start);
+        // the writer thread formats and prints the line, the consumer only copies the event into its own ring.
+        trace_log_dispatch(consumer->consumer_id, begin, previous_burst, !already_running, start, end);
+        if(!already_running)
+        {
+            latency_stats_record_response(&consumer->stats, response_time);
+        }
+        if(is_finished(begin))
+        {
+            unsigned int turnaround_time = getDifferenceInMilliSeconds(begin->oTimeCreated, end);
+            latency_stats_record_completion(&consumer->stats, turnaround_time, begin->iInitialBurstTime);
+            process_release(begin);
+            sem_post(consumer->free_slots);
+            if(atomic_fetch_sub(consumer->processes_left, 1) == 1)
+            {
+                // that was the last one, wake up every CPU so they see there is nothing left.
+                for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+                {
+                    profiled_mutex_lock(&consumer->cpu_queues[i].lock);
+                    pthread_cond_broadcast(&consumer->cpu_queues[i].not_empty);
+                    profiled_mutex_unlock(&consumer->cpu_queues[i].lock);
+                }
+            }
+        }
+        else
+        {
+            // used its whole time slice, back to the end of our own run queue.
+            begin->iReadySince = getTimeInNanoSeconds();
+            add_process(&consumer->cpu_queues[consumer->consumer_id], begin);
+        }
+        latency_stats_record_dispatch(&consumer->stats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
+    }
+    pthread_exit(NULL);
+    // Kill the thread.
+}
+
+void run_rr_per_cpu(struct scheduler_result* result)
+{
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
+    unsigned int i;
+    // the queues sit on cache lines of their own, so they take aligned memory.
+    struct cpu_queue* cpu_queues = (struct cpu_queue*) aligned_alloc(CACHE_LINE_SIZE, NUMBER_OF_CONSUMERS * sizeof(struct cpu_queue));
+    assert(cpu_queues != NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        profiled_mutex_init(&cpu_queues[i].lock, "cpu queue");
+        pthread_cond_init(&cpu_queues[i].not_empty, NULL);
+        run_queue_init(&cpu_queues[i].run_queue);
+    }
+    sem_t free_slots;
+    sem_init(&free_slots, 0, BUFFER_SIZE);
+    atomic_int processes_left = NUMBER_OF_PROCESSES;
+    struct timeval run_start, run_end;
+    gettimeofday(&run_start, NULL);
+    pthread_t creator_thread_handle, balancer_thread_handle;
+    pthread_t* consumer_thread_handle = (pthread_t*) calloc(NUMBER_OF_CONSUMERS, sizeof(pthread_t));
+    struct creator_pack creator;
+    creator.cpu_queues = cpu_queues;
+    creator.free_slots = &free_slots;
+    pthread_create(&creator_thread_handle, NULL, create_processes, &creator);
+    struct balancer_pack balancer;
+    balancer.cpu_queues = cpu_queues;
+    balancer.processes_left = &processes_left;
+    balancer.migrations = 0;
+    balancer.rounds = 0;
+    pthread_create(&balancer_thread_handle, NULL, balance_load, &balancer);
+    // the packs are on the heap: each of them holds the latency histograms of its consumer, and hundreds of consumers would not fit on the stack.
+    struct consumer_pack* consumer = (struct consumer_pack*) calloc(NUMBER_OF_CONSUMERS, sizeof(struct consumer_pack));
+    assert(consumer != NULL && consumer_thread_handle != NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        consumer[i].consumer_id = i;
+        consumer[i].cpu_queues = cpu_queues;
+        consumer[i].free_slots = &free_slots;
+        consumer[i].processes_left = &processes_left;
+        consumer[i].busy_time = 0;
+        consumer[i].migrated_runs = 0;
+        latency_stats_init(&consumer[i].stats);
+        consumer[i].dispatches = 0;
+        pthread_create(&consumer_thread_handle[i], NULL, consume_processes, &consumer[i]);
+    }
+
+    pthread_join(creator_thread_handle, NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        pthread_join(consumer_thread_handle[i], NULL);
+        latency_stats_merge(&result->oStats, &consumer[i].stats);
+        result->iDispatches += consumer[i].dispatches;
+    }
+    gettimeofday(&run_end, NULL);
+    pthread_join(balancer_thread_handle, NULL);
+    long long int wall_time = microseconds_between(run_start, run_end);
+    printf("%ld migrations in %ld load balancing rounds\n", balancer.migrations, balancer.rounds);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+        printf("CPU %u: %ld dispatches, %ld after a migration, utilization = %.1f%%\n", i, consumer[i].dispatches, consumer[i].migrated_runs,
+            wall_time > 0 ? 100.0 * consumer[i].busy_time / wall_time : 0.0);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        pthread_cond_destroy(&cpu_queues[i].not_empty);
+        profiled_mutex_destroy(&cpu_queues[i].lock);
+    }
+    sem_destroy(&free_slots);
+    free(consumer);
+    free(consumer_thread_handle);
+    free(cpu_queues);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    run_rr_per_cpu(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
+    profiled_mutex_print_stats();
+    return 0;
+}
+#endif
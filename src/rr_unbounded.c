@@ -1,6 +1,12 @@
 #include "posix_utility.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
 
 
 /*
@@ -8,112 +14,85 @@
     Predefined constraints are preprocessor macros in 'posix_utility.h'
 */
 
-// Using this as a helper function
-void swap(struct process** left, struct process** right)
-{
-    struct process* temp = *left;
-    *left = *right;
-    *right = temp;
-}
-
-// RR, add the process to the end of the list.
-void add_process(struct process* head, struct process* a_process)
-{
-    if(head == (void*)0)
-        return;
-    while(head->oNext != (void*)0)
-    {
-        head = head->oNext;
-    }
-    head->oNext = a_process;
-}
-
-// Take double pointer to head remains true.
-void remove_process(struct process** head, struct process* to_remove)
-{
-    struct process* process_head = *head;
-    if(process_head == (void*)0)
-        return;
-    if(process_head == to_remove)
-    {
-        struct process* tmp = process_head;
-        head = &process_head->oNext;
-        free(process_head);
-    }
-    while(process_head->oNext != (void*)0)
-    {
-        if(process_head->oNext == to_remove)
-        {
-            if(to_remove->oNext != (void*)0)
-                process_head->oNext = to_remove->oNext;
-            free(to_remove);
-        }
-        process_head = process_head->oNext;
-    }
-}
-
-int is_finished(struct process* a_process)
+static int is_finished(struct process* a_process)
 {
     return a_process->iState == FINISHED;
 }
 
-int all_finished(struct process* process_head)
-{
-    while(process_head != (void*)0)
-    {
-        if(process_head->iState != FINISHED)
-            return 0;
-        process_head = process_head->oNext;
-    }
-    return 1;
-}
-
-int main()
+void run_rr_unbounded(struct scheduler_result* result)
 {
-    unsigned int total_turnaround_time = 0;
-    unsigned int total_response_time = 0;
-    // Give me a process. Linked List is currently sorted as contains one element.
-    struct process* process_head = generateProcess();
-    struct process* process_tail = process_head;
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
+    // the processes are drawn from the same stream as the creator threads of the other schedulers, so they all see the same workload.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    // The ready queue keeps its head, tail and length, so appending and taking the front are O(1) and the run is linear in the number of dispatches.
+    struct run_queue ready_queue;
+    run_queue_init(&ready_queue);
     unsigned int i;
     // make number of processes we've allocated equal to the macro
     for(i = 0; i < NUMBER_OF_PROCESSES; i++)
     {
         struct process* a_process = generateProcess();
-        add_process(process_head, a_process);
-        process_tail = a_process;
+        run_queue_push_back(&ready_queue, a_process);
     }
 
-    struct process* tmp = process_head;
-    while(!all_finished(process_head))
+    struct process* tmp;
+    long long int selecting = getTimeInNanoSeconds();
+    // finished processes leave the queue, so once it is empty every process has finished.
+    while((tmp = run_queue_pop_front(&ready_queue)) != (void*)0)
     {
         struct timeval start, end;
         int previous_burst = tmp->iBurstTime;
         int already_running = 0;
         if(tmp->iState == RUNNING || tmp->iState == READY)
             already_running = 1;
+        long long int ready_since = tmp->iReadySince;
+        long long int running = getTimeInNanoSeconds();
         simulateRoundRobinProcess(tmp, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        result->iDispatches++;
         unsigned int response_time = getDifferenceInMilliSeconds(tmp->oTimeCreated, start);
-        printf("pid = %d, previous burst = %d, new burst = %d", tmp->iProcessId, previous_burst, tmp->iBurstTime);
+        // the line is formatted and printed by the trace writer thread.
+        trace_log_dispatch(-1, tmp, previous_burst, !already_running, start, end);
         if(!already_running)
         {
-            printf(", response time = %ld", response_time);
-            total_response_time += response_time;
+            latency_stats_record_response(&result->oStats, response_time);
         }
-        struct process* check = tmp;
-        if(tmp->oNext == (void*)0)
-            tmp = process_head;
-        else
-            tmp = tmp->oNext;
-        if(is_finished(check))
+        if(is_finished(tmp))
         {
             unsigned int turnaround_time = getDifferenceInMilliSeconds(tmp->oTimeCreated, end);
-            printf(", turnaround time = %ld", turnaround_time);
-            total_turnaround_time += turnaround_time;
-            remove_process(&process_head, check);
+            latency_stats_record_completion(&result->oStats, turnaround_time, tmp->iInitialBurstTime);
+            process_release(tmp);
         }
-        printf("\n");
+        else
+        {
+            // used its whole time slice, back to the end of the queue.
+            tmp->iReadySince = getTimeInNanoSeconds();
+            run_queue_push_back(&ready_queue, tmp);
+        }
+        long long int done = getTimeInNanoSeconds();
+        latency_stats_record_dispatch(&result->oStats, ready_since, selecting, running, stopped, done);
+        selecting = done;
     }
-    printf("Done. Average Response Time = %ldms, Average Turnaround Time = %ldms\n", total_response_time / NUMBER_OF_PROCESSES, total_turnaround_time / NUMBER_OF_PROCESSES);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    run_rr_unbounded(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
     return 0;
-}
\ No newline at end of file
+}
+#endif
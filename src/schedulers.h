@@ -0,0 +1,31 @@
+#ifndef SCHEDULERS_H
+#define SCHEDULERS_H
+
+#include "latency_stats.h"
+
+/*
+ * Entry points of the scheduler programs, so that the benchmark driver can run all of them in one executable.
+ * Every program has a main of its own as well, unless it is compiled with SCHEDULER_NO_MAIN defined.
+ * A run uses the sizes in oSchedulerParameters, and leaves the latencies and the number of dispatches in oResult.
+ */
+struct scheduler_result
+{
+	struct latency_stats oStats;
+	long int iDispatches;
+};
+
+void run_sjf_unbounded(struct scheduler_result * oResult);
+void run_rr_unbounded(struct scheduler_result * oResult);
+void run_sjf_bounded(struct scheduler_result * oResult);
+void run_sjf_bounded_multiple_consumers(struct scheduler_result * oResult);
+void run_srtf_multiple_consumers(struct scheduler_result * oResult);
+void run_rr_bounded_multiple_consumers(struct scheduler_result * oResult);
+void run_rr_blocking_multiple_consumers(struct scheduler_result * oResult);
+void run_sjf_batch(struct scheduler_result * oResult);
+void run_mlfq_multiple_consumers(struct scheduler_result * oResult);
+void run_cfs_multiple_consumers(struct scheduler_result * oResult);
+void run_edf_single_consumer(struct scheduler_result * oResult);
+void run_edf_multiple_consumers(struct scheduler_result * oResult);
+void run_rr_per_cpu(struct scheduler_result * oResult);
+
+#endif
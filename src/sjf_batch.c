@@ -0,0 +1,77 @@
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "process_table.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
+
+/*
+    Batch SJF (Shortest-Job-First) Implementation of predefined process.
+    Processes are admitted in batches of BUFFER_SIZE, and before every dispatch the whole ready set is rescanned for the shortest job.
+    The ready set is a structure of arrays, so the rescan is a vectorised pass over the burst times, see 'process_table.h'.
+    Predefined constraints are preprocessor macros in 'posix_utility.h'
+*/
+
+void run_sjf_batch(struct scheduler_result* result)
+{
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
+    // the processes are drawn from the same stream as the creator threads of the other schedulers, so they all see the same workload.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    struct process_table ready_set;
+    process_table_init(&ready_set, NUMBER_OF_PROCESSES);
+    int generated = 0;
+    struct process* tmp;
+    do
+    {
+        // the next batch arrives before the shortest job is picked.
+        int i;
+        for(i = 0; i < BUFFER_SIZE && generated < NUMBER_OF_PROCESSES; i++, generated++)
+            process_table_insert(&ready_set, generateProcess());
+        long long int selecting = getTimeInNanoSeconds();
+        if((tmp = process_table_pop_shortest(&ready_set)) == (void*)0)
+            break;
+        struct timeval start, end;
+        int previous_burst = tmp->iBurstTime;
+        long long int ready_since = tmp->iReadySince;
+        long long int running = getTimeInNanoSeconds();
+        simulateSJFProcess(tmp, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        result->iDispatches++;
+        unsigned int response_time = getDifferenceInMilliSeconds(tmp->oTimeCreated, start);
+        // the line is formatted and printed by the trace writer thread.
+        trace_log_dispatch(-1, tmp, previous_burst, 1, start, end);
+        unsigned int turnaround_time = getDifferenceInMilliSeconds(tmp->oTimeCreated, end);
+        latency_stats_record_response(&result->oStats, response_time);
+        latency_stats_record_completion(&result->oStats, turnaround_time, tmp->iInitialBurstTime);
+        process_release(tmp);
+        latency_stats_record_dispatch(&result->oStats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
+    } while(1);
+    process_table_destroy(&ready_set);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    printf("Shortest job selection: %s\n", process_table_implementation());
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    run_sjf_batch(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
+    return 0;
+}
+#endif
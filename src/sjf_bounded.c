@@ -4,270 +4,179 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <assert.h>
+#include "process_heap.h"
+#include "bounded_buffer.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
 
 /*
     SJF Bounded (Shortest-Job-First with Bounding Buffer) Implementation of predefined process.
     Predefined constraints are preprocessor macros in 'posix_utility.h'
 */
 
-// Using this as a helper function
-void swap(struct process** left, struct process** right)
-{
-    struct process* temp = *left;
-    *left = *right;
-    *right = temp;
-}
-
-// Quick and dirty way to get size of linked list. size_t as opposed to unsigned int as values inputted into things like operator[] are not unsigned ints, and do have different limits.
-// size_t declared in stdlib.h and stddef.h iirc.
-size_t list_size(struct process* head)
-{
-    size_t size = 0;
-    while(head != (void*)0)
-    {
-        size++;
-        head = head->oNext;
-    }
-    return size;
-}
-
 /* pthread functionality requires that all functions ran on a separate thread must return void* and take a single void* parameter.
-however, multiple parameters will be requires, such as a pointer to the head of the process list, a mutex lock etc.
+however, multiple parameters will be requires, such as a pointer to the ready queue, the bounded buffer etc.
 to solve this, the following structs are used to contain all required data:
 */
 
 struct creator_pack
 {
-    pthread_mutex_t* mutex_handle;
-    // This is the shared data. Although this is just a copy of a pointer, the data being pointed to is the shared data.
-    // Therefore whenever consumer runs or edits any process in the list in anyway, mutex lock must be invoked during such execution.
-    struct process** head;
-    unsigned int* creating_finished;
+    // guards the ready queue and tells the creator when there is space and the consumers when there is work.
+    struct bounded_buffer* buffer;
+    // This is the shared data. The ready queue is a min-heap on the burst time.
+    // Therefore whenever creator or consumer edits the queue in anyway, the buffer lock must be held during such execution.
+    struct process_heap* ready_queue;
+    // number of times the creator took the buffer lock to queue its processes.
+    long int lock_acquisitions;
 };
 
 struct consumer_pack
 {
-    pthread_mutex_t* mutex_handle;
+    struct bounded_buffer* buffer;
     // still is the shared data.
-    // head is a double ptr because the head position will change alot.
-    struct process** head;
-    struct process* tail;
-    unsigned int* creating_finished;
-    // Want to access the totals values to edit them with any consumption of processes performed.
-    unsigned int* total_response_time;
-    unsigned int* total_turnaround_time;
+    struct process_heap* ready_queue;
+    // every consumer records into its own statistics block, so consumers never write to the same memory. they are merged once the consumer has been joined.
+    struct latency_stats stats;
+    // number of times this consumer ran a process
+    long int dispatches;
 };
 
-// SJF. edits the list so MUST be mutex locked.
-void add_process(pthread_mutex_t* lock, struct process** head, struct process* a_process)
+// SJF. generates and queues a batch of up to batch_size processes under one acquisition of the buffer lock, and does not walk a sorted list for every process:
+// a batch is pushed in O(k log n), or the heap is rebuilt in O(n) when the batch is at least as large.
+// sleeps until the buffer has space, and only generates as many processes as fit, so a process never waits outside the buffer once it exists. returns how many were queued.
+static size_t add_processes(struct bounded_buffer* buffer, struct process_heap* ready_queue, struct process** batch, size_t batch_size)
 {
-    pthread_mutex_lock(lock);
-    struct process* process_head = *head;
-    if(a_process->iBurstTime < process_head->iBurstTime)
-    {
-        swap(head, &a_process);
-        (*head)->oNext = a_process;
-        pthread_mutex_unlock(lock);
-        return;
-    }
-    struct process* iter = process_head;
-    while(iter->iBurstTime < a_process->iBurstTime)
-    {
-        // (void*)0 is basically exactly what the macro NULL does. Using it like this as NULL confuses me when it's just referring to memloc 0, not necessarily a nullptr
-        if(iter->oNext == (void*)0)
-        {
-            // at the end of the linked list, so this is the longest burst time so far, so make it the tail
-            iter->oNext = a_process;
-            break;
-        }
-        if(iter->oNext->iBurstTime > a_process->iBurstTime)
-        {
-            // needs to be inserted between iter and iter next
-            struct process* tmp = iter->oNext;
-            iter->oNext = a_process;
-            a_process->oNext = tmp;
-        }
-        iter = iter->oNext;
-    }
-    pthread_mutex_unlock(lock);
+    batch_size = bounded_buffer_begin_add_batch(buffer, batch_size);
+    batch_size = generateProcesses(batch, batch_size);
+    process_heap_push_batch(ready_queue, batch, batch_size);
+    bounded_buffer_end_add_batch(buffer, batch_size);
+    return batch_size;
 }
-/*
-void add_process(pthread_mutex_t* lock, struct process** head, struct process* a_process)
+
+// Takes the shortest job out of the queue, sleeping until there is one. returns (void*)0 once the creator is done and every process has finished.
+// selecting is set to the time the consumer found a process in the queue and started selecting.
+static struct process* remove_process(struct bounded_buffer* buffer, struct process_heap* ready_queue, long long int* selecting)
 {
-    pthread_mutex_lock(lock);
-    struct process* head_cpy = *head;
-    if(head_cpy == (void*)0)
-        *head = a_process;
-    while(head_cpy->oNext != (void*)0)
-    {
-        head_cpy = head_cpy->oNext;
-    }
-    head_cpy->oNext = a_process;
-    pthread_mutex_unlock(lock);
+    if(!bounded_buffer_begin_take(buffer))
+        return (void*)0;
+    *selecting = getTimeInNanoSeconds();
+    struct process* shortest = process_heap_pop(ready_queue);
+    bounded_buffer_end_take(buffer);
+    return shortest;
 }
-*/
 
-// Must be ran on a creator package where the process head is just one element.
-void* create_processes(void* creator_package)
+static void* create_processes(void* creator_package)
 {
     struct creator_pack* creator = (struct creator_pack*) creator_package;
-    printf("Asserting list_size == 1...\n");
-    assert(list_size(*creator->head) == 1);
-    size_t processes_created = 1;
+    // the workload is drawn from a random stream of its own, so it is the same in every run whatever the consumers draw.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    // the processes that are being queued. the batch size is only known at run time and may be large, so the batch is not on the stack of the thread.
+    // a batch never holds more processes than fit in the buffer.
+    struct process** batch = (struct process**) calloc(SUBMIT_BATCH_SIZE < BUFFER_SIZE ? SUBMIT_BATCH_SIZE : BUFFER_SIZE, sizeof(struct process*));
+    assert(batch != NULL);
+    size_t processes_created = 0;
     while(processes_created < NUMBER_OF_PROCESSES)
     {
-        // this thread keeps trying to create new processes until the number of processes made in total is what we need.
-        if(list_size(*creator->head) <= BUFFER_SIZE)
-        {
-            // we have space to generate a new process, so do so.
-            struct process* new_process = generateProcess();
-            printf("adding new process...\n");
-            add_process(creator->mutex_handle, creator->head, new_process);
-            processes_created++;
-            printf("Added process to end of the list. Created %d/%d in total.\n", processes_created, NUMBER_OF_PROCESSES);
-        }
-        else
-        {
-            // we arent allowed to generate a new process. the mutex is not locked so we wait, i.e do nothing and sleep.
-            //printf("Buffer Size exceeded, list size = %d, waiting...\n", list_size(*creator->head));
-            //sleep(1);
-        }
+        // this thread keeps creating new processes until the number of processes made in total is what we need.
+        size_t batch_size = NUMBER_OF_PROCESSES - processes_created < (size_t) SUBMIT_BATCH_SIZE ? NUMBER_OF_PROCESSES - processes_created : (size_t) SUBMIT_BATCH_SIZE;
+        // a replayed job that has not arrived yet is waited for before taking the lock, so that waiting never holds up the consumer.
+        waitForNextArrival();
+        printf("adding up to %zu new processes...\n", batch_size);
+        // add_processes blocks while the buffer is full, so there is no need to poll the queue size.
+        size_t added = add_processes(creator->buffer, creator->ready_queue, batch, batch_size);
+        creator->lock_acquisitions++;
+        processes_created += added;
+        printf("Added %zu processes to the ready queue. Created %zu/%d in total.\n", added, processes_created, NUMBER_OF_PROCESSES);
     }
-    //pthread_mutex_lock(creator->mutex_handle);
-    *(creator->creating_finished) = 1;
-    //pthread_mutex_unlock(creator->mutex_handle);
-    // Make the bool true so the other thread can safely read. Shouldn't need to mutex this.
+    bounded_buffer_close(creator->buffer);
+    free(batch);
     pthread_exit(NULL);
     // Kill the thread. We're done creating processes.
 }
 
-// Take double pointer to head remains true. edits the list so MUST be locked!
-void remove_process(pthread_mutex_t* lock, struct process** head, struct process* to_remove)
-{
-    pthread_mutex_lock(lock);
-    struct process* process_head = *head;
-    if(process_head == (void*)0)
-    {
-        pthread_mutex_unlock(lock);
-        return;
-    }
-    if(process_head == to_remove)
-    {
-        struct process* tmp = process_head;
-        *head = process_head->oNext;
-        free(process_head);
-    }
-    while(process_head->oNext != (void*)0)
-    {
-        if(process_head->oNext == to_remove)
-        {
-            if(to_remove->oNext != (void*)0)
-                process_head->oNext = to_remove->oNext;
-            free(to_remove);
-        }
-        process_head = process_head->oNext;
-    }
-    pthread_mutex_unlock(lock);
-}
-
-void* consume_processes(void* consumer_package)
+static void* consume_processes(void* consumer_package)
 {
     struct consumer_pack* consumer = (struct consumer_pack*) consumer_package;
-    //struct process* head_cache = consumer->head;
-    struct process* head = *consumer->head;
-    // when this begins, we will have definitely at least one process in the linked list. apart from that, everything is off the cards.
-    // we must not process and finish the last process (head) though until more are made or no more are being made and we're about to finish up.
-    // the reason for this is that there will be a dangling head ptr which will segfault when the other thread tries to add another process after it.
-    while(*(consumer->creating_finished) == 0 || list_size(head) > 0) // while consumer is still creating or the head is not empty. so stops when not creating anymore and head is empty.
+    struct process* shortest;
+    long long int selecting;
+    // stops when not creating anymore and every process has finished. while there is nothing to do the thread sleeps inside remove_process.
+    while((shortest = remove_process(consumer->buffer, consumer->ready_queue, &selecting)) != (void*)0)
     {
-        // tasks are still on their way and we need to be ready for them too.
-        // just make sure we dont complete the last task.
-        // we cant hack through this though, we do first come first serve. this is why we need the tail i.e never process tail until the loop is ending.
-        if(list_size(head) <= 1 && (*consumer->creating_finished) == 0)
-        {
-            // skip if list size is 1 or less and we're still creating and thus we need to wait.
-            //printf("list size is 1 or less, waiting for more...\n");
-            //sleep(1);
-            continue;
-        }
-        pthread_mutex_lock(consumer->mutex_handle);
-        // perform processing
+        // the process is out of the queue so this thread owns it, no need to hold the lock while it runs.
         struct timeval start, end;
-        int previous_burst = head->iBurstTime;
-        simulateSJFProcess(head, &start, &end);
-        unsigned int response_time = getDifferenceInMilliSeconds(head->oTimeCreated, start);
-        printf("pid = %d, previous burst = %d, new burst = %d", head->iProcessId, previous_burst, head->iBurstTime);
-        printf(", response time = %ld", response_time);
-        *(consumer->total_response_time) += response_time;
-        pthread_mutex_unlock(consumer->mutex_handle);
-
-        unsigned int turnaround_time = getDifferenceInMilliSeconds(head->oTimeCreated, end);
-        printf(", turnaround time = %ld", turnaround_time);
-        //printf("\nprocess being killed. process list size = %d\n", list_size(*consumer->head));
-        *(consumer->total_turnaround_time) += turnaround_time;
-        remove_process(consumer->mutex_handle, consumer->head, head);
-
-        head = *consumer->head;
-        printf("\n");
+        int previous_burst = shortest->iBurstTime;
+        long long int ready_since = shortest->iReadySince;
+        long long int running = getTimeInNanoSeconds();
+        simulateSJFProcess(shortest, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        consumer->dispatches++;
+        unsigned int response_time = getDifferenceInMilliSeconds(shortest->oTimeCreated, start);
+        // the line is formatted and printed by the trace writer thread.
+        trace_log_dispatch(-1, shortest, previous_burst, 1, start, end);
+        latency_stats_record_response(&consumer->stats, response_time);
+
+        unsigned int turnaround_time = getDifferenceInMilliSeconds(shortest->oTimeCreated, end);
+        latency_stats_record_completion(&consumer->stats, turnaround_time, shortest->iInitialBurstTime);
+        process_release(shortest);
+        bounded_buffer_retire(consumer->buffer);
+        latency_stats_record_dispatch(&consumer->stats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
     }
     pthread_exit(NULL);
     // Kill the thread.
 }
 
-int is_finished(struct process* a_process)
+void run_sjf_bounded(struct scheduler_result* result)
 {
-    return a_process->iState == FINISHED;
-}
-
-int all_finished(struct process* process_head)
-{
-    while(process_head != (void*)0)
-    {
-        if(process_head->iState != FINISHED)
-            return 0;
-        process_head = process_head->oNext;
-    }
-    return 1;
-}
-
-int main()
-{
-    unsigned int total_turnaround_time = 0;
-    unsigned int total_response_time = 0;
-    // Give me a process. Linked List is currently sorted as contains one element.
-    struct process* process_head = generateProcess();
-    struct process* process_tail = process_head;
-    unsigned int i;
-    // make number of processes we've allocated equal to the macro
-    /*
-    for(i = 0; i < NUMBER_OF_PROCESSES; i++)
-    {
-        struct process* a_process = generateProcess();
-        add_process(process_head, a_process);
-        process_tail = a_process;
-    }
-    */
-    unsigned int create_done = 0;
-    pthread_mutex_t lock;
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
+    struct process_heap ready_queue;
+    process_heap_init(&ready_queue, BUFFER_SIZE);
+    struct bounded_buffer buffer;
+    bounded_buffer_init(&buffer, BUFFER_SIZE);
     pthread_t creator_thread_handle, consumer_thread_handle;
     struct creator_pack creator;
-    creator.mutex_handle = &lock;
-    creator.head = &process_head;
-    creator.creating_finished = &create_done;
+    creator.buffer = &buffer;
+    creator.ready_queue = &ready_queue;
+    creator.lock_acquisitions = 0;
     pthread_create(&creator_thread_handle, NULL, create_processes, &creator);
     struct consumer_pack consumer;
-    consumer.mutex_handle = &lock;
-    consumer.head = &process_head;
-    consumer.tail = process_tail;
-    consumer.creating_finished = &create_done;
-    consumer.total_response_time = &total_response_time;
-    consumer.total_turnaround_time = &total_turnaround_time;
+    consumer.buffer = &buffer;
+    consumer.ready_queue = &ready_queue;
+    latency_stats_init(&consumer.stats);
+    consumer.dispatches = 0;
     pthread_create(&consumer_thread_handle, NULL, consume_processes, &consumer);
-    // Creator thread separate. Consumption thread unnecessary as that will be done in the main thread.
-    // The reason I do not create another thread for consumption as the main thread will just wait for it anyway so might aswell use it.
 
     pthread_join(creator_thread_handle, NULL);
     pthread_join(consumer_thread_handle, NULL);
-    printf("Done. Average Response Time = %ldms, Average Turnaround Time = %ldms\n", total_response_time / NUMBER_OF_PROCESSES, total_turnaround_time / NUMBER_OF_PROCESSES);
+    latency_stats_merge(&result->oStats, &consumer.stats);
+    result->iDispatches += consumer.dispatches;
+    bounded_buffer_destroy(&buffer);
+    process_heap_destroy(&ready_queue);
+    printf("%d processes submitted in %ld lock acquisitions (%.2f per process)\n", NUMBER_OF_PROCESSES, creator.lock_acquisitions, (double) creator.lock_acquisitions / NUMBER_OF_PROCESSES);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    run_sjf_bounded(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
+    profiled_mutex_print_stats();
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -1,330 +1,374 @@
 #include "posix_utility.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <assert.h>
 #include <unistd.h>
 #include <pthread.h>
-#include <assert.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "process_heap.h"
+#include "profiled_mutex.h"
+#include "process_pool.h"
+#include "child_process.h"
+#include "latency_stats.h"
+#include "trace_log.h"
+#include "schedulers.h"
+#include "workload_trace.h"
 
 /*
     SJF Bounded & MC (Shortest-Job-First with Bounding Buffer and Multiple Consumers) Implementation of predefined process.
+    Every consumer has a local ready queue of its own, ordered on the burst time, which the creator distributes the processes into.
+    A consumer runs the shortest job of its own queue, and when that is empty it steals the shortest job of a randomly chosen other consumer.
+    In the preemptive mode (SRTF, shortest remaining time first) a new process that is shorter than what is left of every running one goes to the consumer with the longest remaining job instead,
+    which notices it within PREEMPTION_CHECK_INTERVAL, puts its own process back into its queue with the remaining burst time and runs the shorter one.
     Predefined constraints are preprocessor macros in 'posix_utility.h'
 */
 
-// Using this as a helper function
-void swap(struct process** left, struct process** right)
-{
-    struct process* temp = *left;
-    *left = *right;
-    *right = temp;
-}
-
-// Quick and dirty way to get size of linked list. size_t as opposed to unsigned int as values inputted into things like operator[] are not unsigned ints, and do have different limits.
-// size_t declared in stdlib.h and stddef.h iirc.
-size_t list_size(struct process* head)
-{
-    size_t size = 0;
-    while(head != (void*)0)
-    {
-        size++;
-        head = head->oNext;
-    }
-    return size;
-}
-
-int is_locked(pthread_mutex_t* mutex)
-{
-    int ret = 1;
-    if(pthread_mutex_trylock(mutex) == 0)
-    {
-       // successfully locked, i.e the mutex was not locked beforehand.
-       ret = 0;
-       pthread_mutex_unlock(mutex);
-    }
-    return ret;
-}
-
-// helper function to aid during development.
-void print_list(struct process* head)
+// a local ready queue. every queue has its own lock and sits on its own cache lines, so consumers only contend when one steals from another.
+struct local_queue
 {
-    struct process* iter = head;
-    int i;
-    for(i = 0; i < list_size(head); i++)
-    {
-        printf("[%d] pid = %d\n", i, iter->iProcessId);
-        iter = iter->oNext;
-    }
-}
+    _Alignas(CACHE_LINE_SIZE) struct profiled_mutex lock;
+    struct process_heap ready_queue;
+    // remaining burst time of the process the consumer runs, 0 while it runs none. only kept up to date in the preemptive mode.
+    atomic_int running_burst;
+    // set by the creator when it has given the consumer a process that is shorter than the one it runs.
+    atomic_int shorter_arrived;
+};
 
 /* pthread functionality requires that all functions ran on a separate thread must return void* and take a single void* parameter.
-however, multiple parameters will be requires, such as a pointer to the head of the process list, a mutex lock etc.
+however, multiple parameters will be requires, such as a pointer to the ready queues, the semaphores etc.
 to solve this, the following structs are used to contain all required data:
 */
 
 struct creator_pack
 {
-    pthread_mutex_t* mutex_handle;
-    // This is the shared data. Although this is just a copy of a pointer, the data being pointed to is the shared data.
-    // Therefore whenever consumer runs or edits any process in the list in anyway, mutex lock must be invoked during such execution.
-    struct process** head;
-    unsigned int* creating_finished;
+    // This is the shared data, one queue per consumer.
+    struct local_queue* local_queues;
+    // counts the space left in the bounded buffer. a process takes a slot when it is created and gives it back when it finishes.
+    sem_t* free_slots;
+    // counts the processes in all the local queues together, so consumers can sleep until there is one.
+    sem_t* queued_processes;
+    int preemptive;
 };
 
 struct consumer_pack
 {
-    pthread_mutex_t* mutex_handle;
     unsigned int consumer_id;
     // still is the shared data.
-    // head is a double ptr because the head position will change alot.
-    struct process** head;
-    struct process* tail;
-    unsigned int* creating_finished;
-    // Want to access the totals values to edit them with any consumption of processes performed.
-    unsigned int* total_response_time;
-    unsigned int* total_turnaround_time;
+    struct local_queue* local_queues;
+    sem_t* free_slots;
+    sem_t* queued_processes;
+    // processes which have not finished yet. the consumer that finishes the last one wakes every consumer up so they can exit.
+    atomic_int* processes_left;
+    unsigned int processes_stolen;
+    int preemptive;
+    // number of times a process of this consumer was taken off it for a shorter one
+    unsigned int preemptions;
+    // every consumer records into its own statistics block, so consumers never write to the same memory. they are merged once the consumer has been joined.
+    struct latency_stats stats;
+    // number of times this consumer ran a process
+    long int dispatches;
 };
 
-// SJF. edits the list so MUST be mutex locked.
-void add_process(pthread_mutex_t* lock, struct process** head, struct process* a_process)
+// SJF. adds the process to a local queue and wakes up a consumer. only locks that one queue.
+static void add_process(struct local_queue* queue, sem_t* queued_processes, struct process* a_process)
 {
-    pthread_mutex_lock(lock);
-    struct process* process_head = *head;
-    if(a_process->iBurstTime < process_head->iBurstTime)
-    {
-        swap(head, &a_process);
-        (*head)->oNext = a_process;
-        pthread_mutex_unlock(lock);
-        return;
-    }
-    struct process* iter = process_head;
-    while(iter->iBurstTime < a_process->iBurstTime)
+    profiled_mutex_lock(&queue->lock);
+    process_heap_push(&queue->ready_queue, a_process);
+    profiled_mutex_unlock(&queue->lock);
+    sem_post(queued_processes);
+}
+
+// Takes the shortest job out of a local queue. returns (void*)0 if the queue is empty.
+static struct process* pop_process(struct local_queue* queue)
+{
+    profiled_mutex_lock(&queue->lock);
+    struct process* shortest = process_heap_pop(&queue->ready_queue);
+    profiled_mutex_unlock(&queue->lock);
+    return shortest;
+}
+
+// Takes the shortest job of our own queue, or steals one if it is empty. sleeps until there is one. returns (void*)0 once every process has finished.
+// selecting is set to the time the consumer got the token of a process and started looking for it.
+static struct process* remove_process(struct consumer_pack* consumer, long long int* selecting)
+{
+    const unsigned int cid = consumer->consumer_id;
+    unsigned int i;
+    // every process in the queues has a token in the semaphore, so once we got one there is a process waiting somewhere for us.
+    sem_wait(consumer->queued_processes);
+    *selecting = getTimeInNanoSeconds();
+    while(1)
     {
-        // (void*)0 is basically exactly what the macro NULL does. Using it like this as NULL confuses me when it's just referring to memloc 0, not necessarily a nullptr
-        if(iter->oNext == (void*)0)
+        struct process* shortest = pop_process(&consumer->local_queues[cid]);
+        if(shortest != (void*)0)
+            return shortest;
+        // start at a random victim so the thieves do not all go for the same queue.
+        unsigned int first_victim = generateRandomNumber(NUMBER_OF_CONSUMERS);
+        for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
         {
-            // at the end of the linked list, so this is the longest burst time so far, so make it the tail
-            iter->oNext = a_process;
-            break;
+            unsigned int victim = (first_victim + i) % NUMBER_OF_CONSUMERS;
+            if(victim == cid)
+                continue;
+            shortest = pop_process(&consumer->local_queues[victim]);
+            if(shortest != (void*)0)
+            {
+                consumer->processes_stolen++;
+                return shortest;
+            }
         }
-        if(iter->oNext->iBurstTime > a_process->iBurstTime)
-        {
-            // needs to be inserted between iter and iter next
-            struct process* tmp = iter->oNext;
-            iter->oNext = a_process;
-            a_process->oNext = tmp;
-        }
-        iter = iter->oNext;
+        if(atomic_load(consumer->processes_left) == 0)
+            return (void*)0;
+        // another consumer took the process from a queue we had already looked at, while the process it had a token for is still somewhere else. look again.
+        sched_yield();
     }
-    pthread_mutex_unlock(lock);
 }
-/*
-void add_process(pthread_mutex_t* lock, struct process** head, struct process* a_process)
+
+// SRTF. returns the consumer whose process has the longest remaining burst time, if that is longer than iBurstTime and every consumer runs one. returns -1 otherwise:
+// an idle consumer takes the new process without preempting anybody.
+static int find_preemption_victim(struct local_queue* local_queues, int burst_time)
 {
-    pthread_mutex_lock(lock);
-    struct process* head_cpy = *head;
-    if(head_cpy == (void*)0)
-        *head = a_process;
-    while(head_cpy->oNext != (void*)0)
+    unsigned int i;
+    int victim = -1;
+    int longest = burst_time;
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
     {
-        head_cpy = head_cpy->oNext;
+        int running_burst = atomic_load(&local_queues[i].running_burst);
+        if(running_burst == 0)
+            return -1;
+        if(running_burst > longest)
+        {
+            longest = running_burst;
+            victim = i;
+        }
     }
-    head_cpy->oNext = a_process;
-    pthread_mutex_unlock(lock);
+    return victim;
 }
-*/
 
-// Must be ran on a creator package where the process head is just one element.
-void* create_processes(void* creator_package)
+// SRTF. true if the queue of the consumer holds a process that is shorter than what is left of the one it runs.
+static int shorter_process_queued(struct local_queue* queue, int remaining_burst)
 {
-    struct creator_pack* creator = (struct creator_pack*) creator_package;
-    printf("Asserting list_size == 1...\n");
-    assert(list_size(*creator->head) == 1);
-    size_t processes_created = 1;
-    while(processes_created < NUMBER_OF_PROCESSES)
+    profiled_mutex_lock(&queue->lock);
+    struct process* shortest = process_heap_peek(&queue->ready_queue);
+    int shorter = shortest != (void*)0 && shortest->iBurstTime < remaining_burst;
+    profiled_mutex_unlock(&queue->lock);
+    return shorter;
+}
+
+// SRTF. runs the process PREEMPTION_CHECK_INTERVAL at a time until it has finished or a shorter one has been given to the consumer. start is when it was first put on the CPU, end when it was last taken off.
+// returns 1 if it was preempted, its state is READY then and its burst time what is left of it.
+static int run_until_preempted(struct consumer_pack* consumer, struct process* a_process, struct timeval* start, struct timeval* end)
+{
+    struct local_queue* own_queue = &consumer->local_queues[consumer->consumer_id];
+    struct timeval slice_start;
+    int first_slice = 1;
+    atomic_store(&own_queue->running_burst, a_process->iBurstTime);
+    while(1)
     {
-        // this thread keeps trying to create new processes until the number of processes made in total is what we need.
-        if(list_size(*creator->head) <= BUFFER_SIZE)
+        simulateRoundRobinProcessWithTimeSlice(a_process, PREEMPTION_CHECK_INTERVAL, first_slice ? start : &slice_start, end);
+        first_slice = 0;
+        atomic_store(&own_queue->running_burst, a_process->iBurstTime);
+        if(a_process->iState == FINISHED)
+            break;
+        // the queue is only looked at when the creator says there is something in it worth looking at, not every interval.
+        if(atomic_exchange(&own_queue->shorter_arrived, 0) && shorter_process_queued(own_queue, a_process->iBurstTime))
         {
-            // we have space to generate a new process, so do so.
-            struct process* new_process = generateProcess();
-            //printf("Adding process...\n");
-            add_process(creator->mutex_handle, creator->head, new_process);
-            processes_created++;
-            //printf("Added process (size now %d). Created %d/%d in total.\n", list_size(*creator->head), processes_created, NUMBER_OF_PROCESSES);
+            atomic_store(&own_queue->running_burst, 0);
+            return 1;
         }
     }
-    pthread_mutex_lock(creator->mutex_handle);
-    *(creator->creating_finished) = 1;
-    pthread_mutex_unlock(creator->mutex_handle);
-    // Make the bool true so the other thread can safely read. Shouldn't need to mutex this.
-    pthread_exit(NULL);
-    // Kill the thread. We're done creating processes.
+    atomic_store(&own_queue->running_burst, 0);
+    return 0;
 }
 
-// Take double pointer to head remains true. edits the list so MUST be locked!
-void remove_process(pthread_mutex_t* lock, struct process** head, struct process* to_remove)
+static void* create_processes(void* creator_package)
 {
-    pthread_mutex_lock(lock);
-    struct process* process_head = *head;
-    if(process_head == (void*)0)
-    {
-        pthread_mutex_unlock(lock);
-        return;
-    }
-    if(process_head == to_remove)
-    {
-        struct process* tmp = process_head;
-        *head = process_head->oNext;
-        free(process_head);
-        //print_list(*head);
-        pthread_mutex_unlock(lock);
-        return;
-    }
-    struct process* previous = process_head;
-    while(process_head != (void*)0)
+    struct creator_pack* creator = (struct creator_pack*) creator_package;
+    // the workload is drawn from a random stream of its own, so it is the same in every run whatever the consumers draw.
+    setRandomStream(RANDOM_STREAM_CREATOR);
+    size_t processes_created = 0;
+    while(processes_created < NUMBER_OF_PROCESSES)
     {
-        if(process_head == to_remove)
+        // this thread keeps creating new processes until the number of processes made in total is what we need.
+        // sleeps while the buffer is full.
+        sem_wait(creator->free_slots);
+        struct process* new_process = generateProcess();
+        // hand the processes out to the consumers in turn, unless the new process should preempt one.
+        int victim = creator->preemptive ? find_preemption_victim(creator->local_queues, new_process->iBurstTime) : -1;
+        if(victim < 0)
+            add_process(&creator->local_queues[processes_created % NUMBER_OF_CONSUMERS], creator->queued_processes, new_process);
+        else
         {
-            if(to_remove != (void*)0)
-                process_head = to_remove;
-            previous->oNext = process_head->oNext;
-            free(to_remove);
-            //print_list(*head);
-            pthread_mutex_unlock(lock);
-            return;
+            add_process(&creator->local_queues[victim], creator->queued_processes, new_process);
+            atomic_store(&creator->local_queues[victim].shorter_arrived, 1);
         }
-        previous = process_head;
-        process_head = process_head->oNext;
+        processes_created++;
     }
-    pthread_mutex_unlock(lock);
+    pthread_exit(NULL);
+    // Kill the thread. We're done creating processes.
 }
 
-void* consume_processes(void* consumer_package)
+static void* consume_processes(void* consumer_package)
 {
     struct consumer_pack* consumer = (struct consumer_pack*) consumer_package;
-    const unsigned int cid = consumer->consumer_id;
+    // the victims to steal from are drawn from the stream of the consumer.
+    setRandomStream(RANDOM_STREAM_CONSUMER(consumer->consumer_id));
+    struct process* shortest;
+    long long int selecting;
     unsigned int i;
-    // because multiple consumers, we dont want to ever actually lock the mutex, just check if its already locked by the creator and sleep if it is.
-    while(*(consumer->creating_finished) == 0 || list_size(*consumer->head) > 0) // thread does not die until we're no longer creating more and the list is completely empty.
+    // stops when not creating anymore and every process has finished. while there is nothing to do the thread sleeps inside remove_process.
+    while((shortest = remove_process(consumer, &selecting)) != (void*)0)
     {
-        // if were not done and we have one more, do not kill the last one
-        // but if we are done and have one more, than we can kill the last one
-        if(*(consumer->creating_finished) == 0 && list_size(*consumer->head) <= 1)
-        {
-            //printf("list size is 1 or less, waiting...\n");
-            //printf("creation finished = %d, list_size = %d\n", *(consumer->creating_finished), list_size(*consumer->head));
-            //sleep(1);
-            continue;
-        }
-        struct process* begin = *consumer->head;
-        int is_ready = 1;
-        for(i = 0; i < cid; i++)
-        {
-            if(list_size(*consumer->head) == 0 || begin->oNext == NULL)
-                is_ready = 0;
-            else
-                begin = begin->oNext;
-        }
-        // move begin to cid position in the list. so if cid = 1, cid is the 1st (not 0th) element of the linked list.
-        if(is_ready == 0)
+        // the process is out of the queue so this thread owns it, no need to hold a lock while it runs.
+        struct timeval start, end;
+        int previous_burst = shortest->iBurstTime;
+        // a preempted process has run before, it is READY instead of NEW.
+        int first_run = shortest->iState == NEW;
+        long long int ready_since = shortest->iReadySince;
+        long long int running = getTimeInNanoSeconds();
+        int preempted = 0;
+        if(consumer->preemptive)
+            preempted = run_until_preempted(consumer, shortest, &start, &end);
+        else
+            simulateSJFProcess(shortest, &start, &end);
+        long long int stopped = getTimeInNanoSeconds();
+        consumer->dispatches++;
+        unsigned int response_time = getDifferenceInMilliSeconds(shortest->oTimeCreated, start);
+        // the writer thread formats and prints the line, the consumer only copies the event into its own ring.
+        trace_log_dispatch(consumer->consumer_id, shortest, previous_burst, first_run, start, end);
+        if(first_run)
+            latency_stats_record_response(&consumer->stats, response_time);
+
+        if(preempted)
         {
-            //printf("cid %d not ready to process... list size = %d\n", cid, list_size(*consumer->head));
-            //sleep(1);
-            continue;
+            // back into our own queue with what is left of it, the shorter process is at the front now.
+            consumer->preemptions++;
+            shortest->iReadySince = getTimeInNanoSeconds();
+            add_process(&consumer->local_queues[consumer->consumer_id], consumer->queued_processes, shortest);
         }
-        if(is_locked(consumer->mutex_handle))
+        else
         {
-            // wait if creation is happening right now or list size is too small.
-            // currently creating more. dont do anything.
-            continue;
+            unsigned int turnaround_time = getDifferenceInMilliSeconds(shortest->oTimeCreated, end);
+            latency_stats_record_completion(&consumer->stats, turnaround_time, shortest->iInitialBurstTime);
+            process_release(shortest);
+            sem_post(consumer->free_slots);
+            if(atomic_fetch_sub(consumer->processes_left, 1) == 1)
+            {
+                // that was the last one, wake up every consumer so they see there is nothing left.
+                for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+                    sem_post(consumer->queued_processes);
+            }
         }
-        // no creation is taking place by now, the list size is fair and our element in the list is valid.
-        //pthread_mutex_lock(consumer->mutex_handle);
-        //printf("cid = %d, head pid = %d, pid to kill = %d\n", cid, (*consumer->head)->iProcessId, begin->iProcessId);
-        struct timeval start, end;
-        int previous_burst = begin->iBurstTime;
-        //print_list(*consumer->head);
-        simulateSJFProcess(begin, &start, &end);
-        unsigned int response_time = getDifferenceInMilliSeconds(begin->oTimeCreated, start);
-        printf("cid = %d, pid = %d, previous burst = %d, new burst = %d", consumer->consumer_id, begin->iProcessId, previous_burst, begin->iBurstTime);
-        printf(", response time = %ld", response_time);
-        *(consumer->total_response_time) += response_time;
-
-        unsigned int turnaround_time = getDifferenceInMilliSeconds(begin->oTimeCreated, end);
-        printf(", turnaround time = %ld\n", turnaround_time);
-        //printf("\nprocess being killed. process list size = %d\n", list_size(*consumer->head));
-        *(consumer->total_turnaround_time) += turnaround_time;
-        remove_process(consumer->mutex_handle, consumer->head, begin);
-        //printf("finished removing process.\n");
-        //printf("list size = %d, done = %d\n", list_size(*consumer->head), *(consumer->creating_finished));
-        //pthread_mutex_unlock(consumer->mutex_handle);
+        latency_stats_record_dispatch(&consumer->stats, ready_since, selecting, running, stopped, getTimeInNanoSeconds());
     }
     pthread_exit(NULL);
     // Kill the thread.
 }
 
-int is_finished(struct process* a_process)
+static void run_sjf(struct scheduler_result* result, int preemptive)
 {
-    return a_process->iState == FINISHED;
-}
-
-int all_finished(struct process* process_head)
-{
-    while(process_head != (void*)0)
-    {
-        if(process_head->iState != FINISHED)
-            return 0;
-        process_head = process_head->oNext;
-    }
-    return 1;
-}
-
-int main()
-{
-    unsigned int total_turnaround_time = 0;
-    unsigned int total_response_time = 0;
-    // Give me a process. Linked List is currently sorted as contains one element.
-    struct process* process_head = generateProcess();
-    struct process* process_tail = process_head;
+    // response, turnaround and waiting times of every process, in milli seconds.
+    latency_stats_init(&result->oStats);
+    result->iDispatches = 0;
     unsigned int i;
-    // make number of processes we've allocated equal to the macro
-    /*
-    for(i = 0; i < NUMBER_OF_PROCESSES; i++)
+    // the queues sit on cache lines of their own, so they take aligned memory.
+    struct local_queue* local_queues = (struct local_queue*) aligned_alloc(CACHE_LINE_SIZE, NUMBER_OF_CONSUMERS * sizeof(struct local_queue));
+    assert(local_queues != NULL);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
     {
-        struct process* a_process = generateProcess();
-        add_process(process_head, a_process);
-        process_tail = a_process;
+        profiled_mutex_init(&local_queues[i].lock, "local queue");
+        process_heap_init(&local_queues[i].ready_queue, BUFFER_SIZE);
+        atomic_init(&local_queues[i].running_burst, 0);
+        atomic_init(&local_queues[i].shorter_arrived, 0);
     }
-    */
-    unsigned int create_done = 0;
-    pthread_mutex_t lock;
-    pthread_t creator_thread_handle, consumer_thread_handle[NUMBER_OF_CONSUMERS];
+    sem_t free_slots, queued_processes;
+    sem_init(&free_slots, 0, BUFFER_SIZE);
+    sem_init(&queued_processes, 0, 0);
+    atomic_int processes_left = NUMBER_OF_PROCESSES;
+    pthread_t creator_thread_handle;
+    pthread_t* consumer_thread_handle = (pthread_t*) calloc(NUMBER_OF_CONSUMERS, sizeof(pthread_t));
     struct creator_pack creator;
-    creator.mutex_handle = &lock;
-    creator.head = &process_head;
-    creator.creating_finished = &create_done;
+    creator.local_queues = local_queues;
+    creator.free_slots = &free_slots;
+    creator.queued_processes = &queued_processes;
+    creator.preemptive = preemptive;
     pthread_create(&creator_thread_handle, NULL, create_processes, &creator);
-    struct consumer_pack consumer[NUMBER_OF_CONSUMERS];
+    // the packs are on the heap: each of them holds the latency histograms of its consumer, and hundreds of consumers would not fit on the stack.
+    struct consumer_pack* consumer = (struct consumer_pack*) calloc(NUMBER_OF_CONSUMERS, sizeof(struct consumer_pack));
+    assert(consumer != NULL && consumer_thread_handle != NULL);
     for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
     {
-        consumer[i].mutex_handle = &lock;
         consumer[i].consumer_id = i;
-        consumer[i].head = &process_head;
-        consumer[i].tail = process_tail;
-        consumer[i].creating_finished = &create_done;
-        consumer[i].total_response_time = &total_response_time;
-        consumer[i].total_turnaround_time = &total_turnaround_time;
+        consumer[i].local_queues = local_queues;
+        consumer[i].free_slots = &free_slots;
+        consumer[i].queued_processes = &queued_processes;
+        consumer[i].processes_left = &processes_left;
+        consumer[i].processes_stolen = 0;
+        consumer[i].preemptive = preemptive;
+        consumer[i].preemptions = 0;
+        latency_stats_init(&consumer[i].stats);
+        consumer[i].dispatches = 0;
         pthread_create(&consumer_thread_handle[i], NULL, consume_processes, &consumer[i]);
     }
-    // Creator thread separate. Consumption thread unnecessary as that will be done in the main thread.
-    // The reason I do not create another thread for consumption as the main thread will just wait for it anyway so might aswell use it.
 
+    unsigned int preemptions = 0;
     pthread_join(creator_thread_handle, NULL);
-    //printf("creator thread joined.\n");
     for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
     {
         pthread_join(consumer_thread_handle[i], NULL);
-        //printf("consumer thread joined.\n");
+        latency_stats_merge(&result->oStats, &consumer[i].stats);
+        result->iDispatches += consumer[i].dispatches;
+        preemptions += consumer[i].preemptions;
+        if(preemptive)
+            printf("cid = %d stole %d processes, %d of its processes were preempted\n", i, consumer[i].processes_stolen, consumer[i].preemptions);
+        else
+            printf("cid = %d stole %d processes\n", i, consumer[i].processes_stolen);
+    }
+    if(preemptive)
+        printf("%d preemptions in total\n", preemptions);
+    for(i = 0; i < NUMBER_OF_CONSUMERS; i++)
+    {
+        process_heap_destroy(&local_queues[i].ready_queue);
+        profiled_mutex_destroy(&local_queues[i].lock);
     }
-    printf("Done. Average Response Time = %ldms, Average Turnaround Time = %ldms\n", total_response_time / NUMBER_OF_PROCESSES, total_turnaround_time / NUMBER_OF_PROCESSES);
+    sem_destroy(&queued_processes);
+    sem_destroy(&free_slots);
+    free(consumer);
+    free(consumer_thread_handle);
+    free(local_queues);
+}
+
+void run_sjf_bounded_multiple_consumers(struct scheduler_result* result)
+{
+    run_sjf(result, 0);
+}
+
+// shortest remaining time first: the same scheduler, with preemption.
+void run_srtf_multiple_consumers(struct scheduler_result* result)
+{
+    run_sjf(result, 1);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+int main(int argc, char** argv)
+{
+    struct scheduler_result result;
+    // an optional workload trace is replayed instead of generating random processes, see 'workload_trace.h'
+    if(argc > 1 && workload_trace_open(argv[1]) < 0)
+        return 1;
+    // every dispatch is traced in the background, see 'trace_log.h'
+    trace_log_open(TRACE_FILE_NAME, TRACE_FORMAT);
+    if(PREEMPTIVE_SJF)
+        run_srtf_multiple_consumers(&result);
+    else
+        run_sjf_bounded_multiple_consumers(&result);
+    trace_log_close();
+    workload_trace_close();
+    printf("Done. Average Response Time = %lldms, Average Turnaround Time = %lldms\n", latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    latency_stats_print(&result.oStats, "ms");
+    process_pool_print_stats();
+    child_process_print_stats();
+    profiled_mutex_print_stats();
     return 0;
-}
\ No newline at end of file
+}
+#endif
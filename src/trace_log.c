@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "trace_log.h"
+
+/*
+ * Ring of one recording thread. Only that thread moves the tail and only the writer moves the head, and each sits on its own cache line.
+ * Rings are kept until the trace is closed, so events of threads that have already exited are still written.
+ */
+struct trace_ring
+{
+	struct trace_event aEvents[TRACE_RING_SIZE];
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t iHead;
+	_Alignas(CACHE_LINE_SIZE) atomic_size_t iTail;
+	long int iDropped;
+	struct trace_ring * oNext;
+};
+
+static __thread struct trace_ring * oLocalRing = NULL;
+
+// every ring that was handed out, only locked when a thread records for the first time and when the writer walks the list
+static pthread_mutex_t oRingsLock = PTHREAD_MUTEX_INITIALIZER;
+static struct trace_ring * oRings = NULL;
+
+static FILE * oOutput = NULL;
+static int iOutputFormat = TRACE_TEXT;
+static pthread_t oWriterThread;
+static atomic_int iStopping = 0;
+// events are only recorded while the trace is open, so the schedulers can also run without one
+static atomic_int iOpen = 0;
+static long int iEventsWritten = 0;
+
+static struct timeval to_timeval(int64_t iMicroSeconds)
+{
+	struct timeval oTime;
+	oTime.tv_sec = iMicroSeconds / 1000000;
+	oTime.tv_usec = iMicroSeconds % 1000000;
+	return oTime;
+}
+
+static int64_t to_micro_seconds(struct timeval oTime)
+{
+	return (int64_t) oTime.tv_sec * 1000000 + oTime.tv_usec;
+}
+
+/*
+ * Writes a single event. The text format is the line the schedulers used to print themselves.
+ */
+static void trace_log_write(const struct trace_event * oEvent)
+{
+	struct timeval oCreated = to_timeval(oEvent->iTimeCreated);
+	long int iResponseTime = getDifferenceInMilliSeconds(oCreated, to_timeval(oEvent->iStartTime));
+	long int iTurnaroundTime = getDifferenceInMilliSeconds(oCreated, to_timeval(oEvent->iEndTime));
+	if(iOutputFormat == TRACE_BINARY)
+	{
+		fwrite(oEvent, sizeof(struct trace_event), 1, oOutput);
+	}
+	else if(iOutputFormat == TRACE_CSV)
+	{
+		fprintf(oOutput, "%d,%d,%lld,%lld,%lld,%d,%d,%d,%d,%d\n", oEvent->iConsumerId, oEvent->iProcessId, (long long int) oEvent->iTimeCreated, (long long int) oEvent->iStartTime,
+			(long long int) oEvent->iEndTime, oEvent->iPreviousBurst, oEvent->iNewBurst, oEvent->iState, oEvent->iEventType, oEvent->iFirstRun);
+	}
+	else
+	{
+		if(oEvent->iConsumerId >= 0)
+			fprintf(oOutput, "cid = %d, ", oEvent->iConsumerId);
+		fprintf(oOutput, "pid = %d, previous burst = %d, new burst = %d", oEvent->iProcessId, oEvent->iPreviousBurst, oEvent->iNewBurst);
+		if(oEvent->iFirstRun)
+			fprintf(oOutput, ", response time = %ld", iResponseTime);
+		if(oEvent->iState == FINISHED)
+			fprintf(oOutput, ", turnaround time = %ld", iTurnaroundTime);
+		else if(oEvent->iState == BLOCKED)
+			fprintf(oOutput, ", blocked on event %d", oEvent->iEventType);
+		fprintf(oOutput, "\n");
+	}
+	iEventsWritten++;
+}
+
+/*
+ * Writes whatever is waiting in the rings. Returns the number of events written.
+ */
+static long int trace_log_drain()
+{
+	long int iWritten = 0;
+	pthread_mutex_lock(&oRingsLock);
+	struct trace_ring * oRing = oRings;
+	pthread_mutex_unlock(&oRingsLock);
+	// rings are only ever added at the head, so the rest of the list can be walked without the lock
+	for(; oRing != NULL; oRing = oRing->oNext)
+	{
+		size_t iHead = atomic_load_explicit(&(oRing->iHead), memory_order_relaxed);
+		size_t iTail = atomic_load_explicit(&(oRing->iTail), memory_order_acquire);
+		size_t i;
+		for(i = iHead; i != iTail; i++)
+			trace_log_write(&(oRing->aEvents[i & (TRACE_RING_SIZE - 1)]));
+		iWritten += iTail - iHead;
+		atomic_store_explicit(&(oRing->iHead), iTail, memory_order_release);
+	}
+	return iWritten;
+}
+
+static void * trace_log_writer(void * oUnused)
+{
+	while(!atomic_load(&iStopping))
+	{
+		if(trace_log_drain() == 0)
+			usleep(TRACE_WRITER_INTERVAL);
+	}
+	pthread_exit(NULL);
+}
+
+/*
+ * Starts the writer thread. sFileName is (void*)0 for standard output, iFormat one of TRACE_TEXT, TRACE_CSV or TRACE_BINARY.
+ */
+void trace_log_open(const char * sFileName, int iFormat)
+{
+	assert(oOutput == NULL);
+	if(sFileName == NULL)
+		oOutput = stdout;
+	else
+		oOutput = fopen(sFileName, iFormat == TRACE_BINARY ? "wb" : "w");
+	assert(oOutput != NULL);
+	iOutputFormat = iFormat;
+	iEventsWritten = 0;
+	atomic_store(&iStopping, 0);
+	if(iFormat == TRACE_BINARY)
+	{
+		int32_t aHeader[2] = {TRACE_VERSION, sizeof(struct trace_event)};
+		fwrite(TRACE_MAGIC, 4, 1, oOutput);
+		fwrite(aHeader, sizeof(aHeader), 1, oOutput);
+	}
+	else if(iFormat == TRACE_CSV)
+	{
+		fprintf(oOutput, "consumer,pid,created_us,start_us,end_us,previous_burst,new_burst,state,event_type,first_run\n");
+	}
+	pthread_create(&oWriterThread, NULL, trace_log_writer, NULL);
+	atomic_store(&iOpen, 1);
+}
+
+/*
+ * Queues a copy of the event for the writer, if the trace is open. Never blocks: if the writer has fallen a whole ring behind, the event is dropped.
+ */
+void trace_log_record(const struct trace_event * oEvent)
+{
+	if(!atomic_load_explicit(&iOpen, memory_order_relaxed))
+		return;
+	struct trace_ring * oRing = oLocalRing;
+	if(oRing == NULL)
+	{
+		oRing = (struct trace_ring *) aligned_alloc(CACHE_LINE_SIZE, sizeof(struct trace_ring));
+		assert(oRing != NULL);
+		atomic_init(&(oRing->iHead), 0);
+		atomic_init(&(oRing->iTail), 0);
+		oRing->iDropped = 0;
+		pthread_mutex_lock(&oRingsLock);
+		oRing->oNext = oRings;
+		oRings = oRing;
+		pthread_mutex_unlock(&oRingsLock);
+		oLocalRing = oRing;
+	}
+	size_t iTail = atomic_load_explicit(&(oRing->iTail), memory_order_relaxed);
+	if(iTail - atomic_load_explicit(&(oRing->iHead), memory_order_acquire) == TRACE_RING_SIZE)
+	{
+		oRing->iDropped++;
+		return;
+	}
+	oRing->aEvents[iTail & (TRACE_RING_SIZE - 1)] = *oEvent;
+	atomic_store_explicit(&(oRing->iTail), iTail + 1, memory_order_release);
+}
+
+/*
+ * Records that oTemp has just been run by the given consumer.
+ */
+void trace_log_dispatch(int iConsumerId, const struct process * oTemp, int iPreviousBurst, int iFirstRun, struct timeval oStartTime, struct timeval oEndTime)
+{
+	struct trace_event oEvent;
+	oEvent.iTimeCreated = to_micro_seconds(oTemp->oTimeCreated);
+	oEvent.iStartTime = to_micro_seconds(oStartTime);
+	oEvent.iEndTime = to_micro_seconds(oEndTime);
+	oEvent.iProcessId = oTemp->iProcessId;
+	oEvent.iConsumerId = iConsumerId;
+	oEvent.iPreviousBurst = iPreviousBurst;
+	oEvent.iNewBurst = oTemp->iBurstTime;
+	oEvent.iState = oTemp->iState;
+	oEvent.iEventType = oTemp->iEventType;
+	oEvent.iFirstRun = iFirstRun;
+	oEvent.iPadding = 0;
+	trace_log_record(&oEvent);
+}
+
+/*
+ * Stops the writer, writes the events that are left and frees the rings. Call it once every thread that records has been joined.
+ */
+void trace_log_close()
+{
+	long int iDropped = 0;
+	atomic_store(&iOpen, 0);
+	atomic_store(&iStopping, 1);
+	pthread_join(oWriterThread, NULL);
+	trace_log_drain();
+	pthread_mutex_lock(&oRingsLock);
+	while(oRings != NULL)
+	{
+		struct trace_ring * oRing = oRings;
+		oRings = oRing->oNext;
+		iDropped += oRing->iDropped;
+		free(oRing);
+	}
+	pthread_mutex_unlock(&oRingsLock);
+	oLocalRing = NULL;
+	fflush(oOutput);
+	if(oOutput != stdout)
+		fclose(oOutput);
+	oOutput = NULL;
+	printf("Trace log: %ld events written, %ld dropped\n", iEventsWritten, iDropped);
+}
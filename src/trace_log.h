@@ -0,0 +1,49 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <stdint.h>
+#include <sys/time.h>
+#include "posix_utility.h"
+
+// number of events every thread can have waiting for the writer, must be a power of two. events recorded while the ring is full are dropped and counted
+#define TRACE_RING_SIZE 8192
+
+// time, in micro seconds, the writer thread sleeps when there was nothing to write
+#define TRACE_WRITER_INTERVAL 1000
+
+// first bytes of a binary trace, followed by the format version and the size of an event
+#define TRACE_MAGIC "STRC"
+#define TRACE_VERSION 1
+
+/*
+ * One dispatch of a process, as recorded by the consumer that ran it. The layout is fixed so that binary traces can be read back on any platform.
+ * Times are in micro seconds since the epoch, or of the virtual clock.
+ */
+struct trace_event
+{
+	int64_t iTimeCreated;
+	int64_t iStartTime;
+	int64_t iEndTime;
+	int32_t iProcessId;
+	// -1 for the single threaded schedulers
+	int32_t iConsumerId;
+	int32_t iPreviousBurst;
+	int32_t iNewBurst;
+	// state of the process after the dispatch, FINISHED, BLOCKED or READY
+	int32_t iState;
+	int32_t iEventType;
+	// 1 if this was the first time the process ran, the response time is only meaningful then
+	int32_t iFirstRun;
+	int32_t iPadding;
+};
+
+/*
+ * Asynchronous dispatch trace. Every thread that records gets a single-producer/single-consumer ring of its own the first time it records,
+ * so recording an event is a copy and a release store, without locks or system calls. A background thread drains all rings to the trace file.
+ */
+void trace_log_open(const char * sFileName, int iFormat);
+void trace_log_record(const struct trace_event * oEvent);
+void trace_log_dispatch(int iConsumerId, const struct process * oTemp, int iPreviousBurst, int iFirstRun, struct timeval oStartTime, struct timeval oEndTime);
+void trace_log_close();
+
+#endif
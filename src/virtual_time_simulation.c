@@ -0,0 +1,37 @@
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "event_simulation.h"
+#include "process_pool.h"
+
+/*
+    Discrete-event (virtual time) simulation of the SJF, RR and blocking RR schedulers.
+    Nothing spins for the burst times, so the number of processes is only limited by how fast the events can be processed.
+    Predefined constraints are preprocessor macros in 'posix_utility.h'
+*/
+
+void run_policy(const char* name, int policy)
+{
+    struct event_simulation_result result;
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    simulateDiscreteEvents(policy, SIMULATION_NUMBER_OF_PROCESSES, NUMBER_OF_CONSUMERS, BUFFER_SIZE, &result);
+    gettimeofday(&end, NULL);
+    long int wall_time = getDifferenceInMilliSeconds(start, end);
+    printf("%s: %ld processes, %ld dispatches, virtual time = %ldms, Average Response Time = %lldms, Average Turnaround Time = %lldms", name, result.iProcesses, result.iDispatches, result.iMakespan, latency_histogram_mean(&result.oStats.oResponseTime), latency_histogram_mean(&result.oStats.oTurnaroundTime));
+    // wall time can be 0 for small runs.
+    if(wall_time > 0)
+        printf(", simulated %ld processes per second", result.iProcesses * 1000 / wall_time);
+    printf("\n");
+    latency_stats_print(&result.oStats, "ms");
+}
+
+int main()
+{
+    run_policy("SJF", POLICY_SJF);
+    run_policy("RR", POLICY_ROUND_ROBIN);
+    run_policy("Blocking RR", POLICY_BLOCKING_ROUND_ROBIN);
+    process_pool_print_stats();
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "posix_utility.h"
+#include "workload_trace.h"
+
+// the trace being replayed. there is only one, as there is only one generateProcess.
+static const unsigned char * pMapping = NULL;
+static size_t iMappingSize = 0;
+static const struct workload_record * aRecords = NULL;
+static long int iNumberOfJobs = 0;
+static long int iNextJob = 0;
+// bytes at the start of the mapping that have been given back to the kernel
+static size_t iReleased = 0;
+static int iStarted = 0;
+static struct timeval oArrivalTime;
+
+/*
+ * Maps the trace and makes generateProcess replay it. The number of processes the schedulers create is set to the number of jobs in the trace.
+ * Returns the number of jobs, or -1 (after printing why) if the file is not a workload trace.
+ */
+long int workload_trace_open(const char * sFileName)
+{
+	struct stat oStat;
+	workload_trace_close();
+	int iFile = open(sFileName, O_RDONLY);
+	if(iFile < 0 || fstat(iFile, &oStat) < 0)
+	{
+		perror(sFileName);
+		if(iFile >= 0)
+			close(iFile);
+		return -1;
+	}
+	const struct workload_trace_header * oHeader = NULL;
+	void * pMapped = MAP_FAILED;
+	if((size_t) oStat.st_size >= sizeof(struct workload_trace_header))
+		pMapped = mmap(NULL, oStat.st_size, PROT_READ, MAP_PRIVATE, iFile, 0);
+	// the mapping keeps the file open
+	close(iFile);
+	if(pMapped != MAP_FAILED)
+		oHeader = (const struct workload_trace_header *) pMapped;
+	if(oHeader == NULL || memcmp(oHeader->aMagic, WORKLOAD_TRACE_MAGIC, 4) != 0 || oHeader->iVersion != WORKLOAD_TRACE_VERSION
+		|| oStat.st_size != sizeof(struct workload_trace_header) + oHeader->iNumberOfJobs * sizeof(struct workload_record))
+	{
+		fprintf(stderr, "%s: not a version %d workload trace\n", sFileName, WORKLOAD_TRACE_VERSION);
+		if(pMapped != MAP_FAILED)
+			munmap(pMapped, oStat.st_size);
+		return -1;
+	}
+	// the records are read front to back exactly once
+	madvise(pMapped, oStat.st_size, MADV_SEQUENTIAL);
+	pMapping = (const unsigned char *) pMapped;
+	iMappingSize = oStat.st_size;
+	aRecords = (const struct workload_record *) (pMapping + sizeof(struct workload_trace_header));
+	iNumberOfJobs = oHeader->iNumberOfJobs;
+	iNextJob = 0;
+	iReleased = 0;
+	iStarted = 0;
+	oSchedulerParameters.iNumberOfProcesses = iNumberOfJobs;
+	return iNumberOfJobs;
+}
+
+int workload_trace_active()
+{
+	return pMapping != NULL;
+}
+
+/*
+ * Copies the next job into oRecord and returns its arrival time, counted from the first call. Returns 0 once every job has been replayed.
+ */
+int workload_trace_next(struct workload_record * oRecord, struct timeval * oTime)
+{
+	if(iNextJob == iNumberOfJobs)
+		return 0;
+	if(!iStarted)
+	{
+		getCurrentTime(&oArrivalTime);
+		iStarted = 1;
+	}
+	*oRecord = aRecords[iNextJob++];
+	addMilliSeconds(&oArrivalTime, oRecord->iArrivalOffset);
+	*oTime = oArrivalTime;
+	size_t iRead = (const unsigned char *) &aRecords[iNextJob] - pMapping;
+	if(iRead - iReleased >= WORKLOAD_TRACE_RELEASE_SIZE)
+	{
+		// only whole pages that have been read completely
+		size_t iPageSize = sysconf(_SC_PAGESIZE);
+		size_t iEnd = iRead / iPageSize * iPageSize;
+		madvise((void *) (pMapping + iReleased), iEnd - iReleased, MADV_DONTNEED);
+		iReleased = iEnd;
+	}
+	return 1;
+}
+
+/*
+ * Sets oTime to the arrival time of the next job without taking it. Returns 0 once every job has been replayed. The replay starts at the first call of this function or of workload_trace_next.
+ */
+int workload_trace_next_arrival(struct timeval * oTime)
+{
+	if(iNextJob == iNumberOfJobs)
+		return 0;
+	if(!iStarted)
+	{
+		getCurrentTime(&oArrivalTime);
+		iStarted = 1;
+	}
+	*oTime = oArrivalTime;
+	addMilliSeconds(oTime, aRecords[iNextJob].iArrivalOffset);
+	return 1;
+}
+
+/*
+ * Stops replaying, generateProcess goes back to random processes. Does nothing if no trace is open.
+ */
+void workload_trace_close()
+{
+	if(pMapping == NULL)
+		return;
+	munmap((void *) pMapping, iMappingSize);
+	pMapping = NULL;
+	aRecords = NULL;
+	iMappingSize = 0;
+	iNumberOfJobs = 0;
+	iNextJob = 0;
+}
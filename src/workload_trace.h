@@ -0,0 +1,46 @@
+#ifndef WORKLOAD_TRACE_H
+#define WORKLOAD_TRACE_H
+
+#include <stdint.h>
+#include <sys/time.h>
+
+// first bytes of a workload trace
+#define WORKLOAD_TRACE_MAGIC "SWKL"
+#define WORKLOAD_TRACE_VERSION 1
+
+// the pages of the trace that have been replayed are given back to the kernel every time this many bytes have been read, so a replay uses constant memory
+#define WORKLOAD_TRACE_RELEASE_SIZE (8 * 1024 * 1024)
+
+/*
+ * A workload trace is a header followed by one record per job, in order of arrival. All fields are little endian, as written by the platform the schedulers run on.
+ */
+struct workload_trace_header
+{
+	char aMagic[4];
+	uint32_t iVersion;
+	uint64_t iNumberOfJobs;
+};
+
+struct workload_record
+{
+	// milli seconds between the arrival of the previous job (or the start of the replay) and this one
+	uint32_t iArrivalOffset;
+	int32_t iBurstTime;
+	// used as the nice value of the job by the fair scheduler, -20 to 19
+	int16_t iPriority;
+	// probability (percent) that the job blocks when it runs under the blocking round robin scheduler, below 100
+	uint8_t iBlockingProbability;
+	uint8_t iReserved;
+};
+
+/*
+ * Replays a workload trace instead of generating random processes. While a trace is open, generateProcess takes the next job of the trace.
+ * The trace is read through mmap: records are copied straight out of the page cache as the creator needs them, there is no parse step, and pages that have been replayed are released again.
+ */
+long int workload_trace_open(const char * sFileName);
+int workload_trace_active();
+int workload_trace_next(struct workload_record * oRecord, struct timeval * oArrivalTime);
+int workload_trace_next_arrival(struct timeval * oArrivalTime);
+void workload_trace_close();
+
+#endif
@@ -0,0 +1,95 @@
+#include "posix_utility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "workload_trace.h"
+
+/*
+    Writes a workload trace for the schedulers to replay (see 'workload_trace.h').
+
+    usage: workload_trace_tool FILE           converts a job mix from standard input, one job per line: arrival offset (ms), burst time (ms), priority, blocking probability (percent)
+                                              a job that always blocks would never finish, so the blocking probability must be below 100
+           workload_trace_tool FILE JOBS      writes JOBS random jobs, drawn like generateProcess does
+*/
+
+// largest time, in milli seconds, between the arrivals of two random jobs
+#define MAX_ARRIVAL_INTERVAL 20
+
+// reads the next job from the CSV on standard input. returns 0 at the end of the input, exits on a line that is not a job.
+static int read_job(struct workload_record* record)
+{
+    static long int line = 0;
+    char text[256];
+    unsigned long int arrival_offset;
+    int burst_time, priority, blocking_probability;
+    while(fgets(text, sizeof(text), stdin) != (void*)0)
+    {
+        line++;
+        // empty lines, comments and a header are skipped.
+        if(text[0] == '\n' || text[0] == '#' || (line == 1 && (text[0] < '0' || text[0] > '9')))
+            continue;
+        if(sscanf(text, "%lu,%d,%d,%d", &arrival_offset, &burst_time, &priority, &blocking_probability) != 4
+            || burst_time <= 0 || blocking_probability < 0 || blocking_probability >= 100)
+        {
+            fprintf(stderr, "line %ld: expected arrival offset, burst time > 0, priority, blocking probability < 100\n", line);
+            exit(1);
+        }
+        record->iArrivalOffset = arrival_offset;
+        record->iBurstTime = burst_time;
+        record->iPriority = priority;
+        record->iBlockingProbability = blocking_probability;
+        record->iReserved = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static void random_job(struct workload_record* record)
+{
+    record->iArrivalOffset = generateRandomNumber(MAX_ARRIVAL_INTERVAL + 1);
+    record->iBurstTime = generateRandomNumber(MAX_BURST_TIME) + 1;
+    record->iPriority = 0;
+    record->iBlockingProbability = BLOCKING_PROBABILITY;
+    record->iReserved = 0;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "usage: %s FILE [JOBS]\n", argv[0]);
+        return 1;
+    }
+    FILE* output = fopen(argv[1], "wb");
+    if(output == (void*)0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    long int jobs = argc == 3 ? atol(argv[2]) : -1;
+    // the number of jobs is only known at the end when converting, so the header is written again then.
+    struct workload_trace_header header;
+    memcpy(header.aMagic, WORKLOAD_TRACE_MAGIC, 4);
+    header.iVersion = WORKLOAD_TRACE_VERSION;
+    header.iNumberOfJobs = 0;
+    fwrite(&header, sizeof(header), 1, output);
+    struct workload_record record;
+    long int written = 0;
+    while(jobs < 0 ? read_job(&record) : written < jobs)
+    {
+        if(jobs >= 0)
+            random_job(&record);
+        fwrite(&record, sizeof(record), 1, output);
+        written++;
+    }
+    header.iNumberOfJobs = written;
+    fseek(output, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, output);
+    if(fclose(output) != 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "%ld jobs written to %s\n", written, argv[1]);
+    return 0;
+}